@@ -0,0 +1,180 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_state.h"
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Двунаправленный A*: прямой поиск от from и обратный от to с усреднёнными потенциалами.
+// lower_bound(u, v) должна давать допустимую и согласованную нижнюю оценку веса пути u -> v.
+template <typename Weight>
+class BidirectionalAStarRouter : public RouteEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using typename RouteEngine<Weight>::RouteInfo;
+    using LowerBound = std::function<Weight(VertexId from, VertexId to)>;
+
+    BidirectionalAStarRouter(const Graph& graph, LowerBound lower_bound);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    size_t GetMemoryUsage() const override {
+        return memory::GetHeapBytes(incoming_offsets_) + memory::GetHeapBytes(incoming_edges_);
+    }
+
+private:
+    struct SearchStates {
+        SearchState<Weight> forward;
+        SearchState<Weight> backward;
+    };
+
+    static SearchStates& GetSearchStates() {
+        thread_local SearchStates states;
+        return states;
+    }
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    LowerBound lower_bound_;
+    // Входящие рёбра вершин в сжатом виде: рёбра вершины v лежат в
+    // incoming_edges_[incoming_offsets_[v] .. incoming_offsets_[v + 1])
+    std::vector<size_t> incoming_offsets_;
+    std::vector<EdgeId> incoming_edges_;
+};
+
+template <typename Weight>
+BidirectionalAStarRouter<Weight>::BidirectionalAStarRouter(const Graph& graph, LowerBound lower_bound)
+    : graph_(graph)
+    , lower_bound_(std::move(lower_bound))
+    , incoming_offsets_(graph.GetVertexCount() + 1, 0)
+    , incoming_edges_(graph.GetEdgeCount())
+{
+    const size_t edge_count = graph.GetEdgeCount();
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        ++incoming_offsets_[edge.to + 1];
+    }
+    std::partial_sum(incoming_offsets_.begin(), incoming_offsets_.end(), incoming_offsets_.begin());
+
+    std::vector<size_t> positions(incoming_offsets_.begin(), incoming_offsets_.end() - 1);
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        incoming_edges_[positions[graph.GetEdge(edge_id).to]++] = edge_id;
+    }
+}
+
+template <typename Weight>
+std::optional<typename BidirectionalAStarRouter<Weight>::RouteInfo>
+BidirectionalAStarRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (from == to) {
+        return RouteInfo{ZERO_WEIGHT, {}};
+    }
+
+    // Потенциал прямого поиска; у обратного он с противоположным знаком.
+    // Приведённые веса рёбер при этом одинаковы в обоих направлениях.
+    const auto potential = [this, from, to](VertexId vertex) {
+        return (lower_bound_(vertex, to) - lower_bound_(from, vertex)) / 2;
+    };
+    const Weight potential_from = potential(from);
+    const Weight potential_to = potential(to);
+
+    auto& [forward, backward] = GetSearchStates();
+    forward.Prepare(vertex_count);
+    backward.Prepare(vertex_count);
+
+    forward.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    forward.Push(ZERO_WEIGHT, from);
+    backward.Reach(to, ZERO_WEIGHT, NO_EDGE);
+    backward.Push(ZERO_WEIGHT, to);
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+    const auto update_best = [&](VertexId vertex) {
+        if (forward.IsReached(vertex) && backward.IsReached(vertex)) {
+            const Weight weight = forward.weights[vertex] + backward.weights[vertex];
+            if (!best_weight || weight < *best_weight) {
+                best_weight = weight;
+                meeting_vertex = vertex;
+            }
+        }
+    };
+
+    while (!forward.heap.empty() && !backward.heap.empty()) {
+        const Weight forward_top = forward.heap.front().first;
+        const Weight backward_top = backward.heap.front().first;
+        if (best_weight && forward_top + backward_top >= *best_weight + potential_to - potential_from) {
+            break;
+        }
+
+        const bool is_forward = forward_top <= backward_top;
+        SearchState<Weight>& state = is_forward ? forward : backward;
+        const auto [key, vertex] = state.Pop();
+
+        const Weight weight = state.weights[vertex];
+        const Weight vertex_key = is_forward ? weight + potential(vertex) - potential_from
+                                             : weight - potential(vertex) + potential_to;
+        if (vertex_key < key) {
+            continue;  // устаревшая запись в куче
+        }
+
+        if (is_forward) {
+            for (const auto& edge : graph_.GetIncidentEdges(vertex)) {
+                const Weight candidate_weight = weight + edge.weight;
+                if (!forward.IsReached(edge.to) || candidate_weight < forward.weights[edge.to]) {
+                    forward.Reach(edge.to, candidate_weight, edge.id);
+                    forward.Push(candidate_weight + potential(edge.to) - potential_from, edge.to);
+                    update_best(edge.to);
+                }
+            }
+        } else {
+            for (size_t i = incoming_offsets_[vertex]; i < incoming_offsets_[vertex + 1]; ++i) {
+                const EdgeId edge_id = incoming_edges_[i];
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight candidate_weight = weight + edge.weight;
+                if (!backward.IsReached(edge.from) || candidate_weight < backward.weights[edge.from]) {
+                    backward.Reach(edge.from, candidate_weight, edge_id);
+                    backward.Push(candidate_weight - potential(edge.from) + potential_to, edge.from);
+                    update_best(edge.from);
+                }
+            }
+        }
+    }
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (EdgeId edge_id = forward.prev_edges[meeting_vertex]; edge_id != NO_EDGE;
+         edge_id = forward.prev_edges[graph_.GetEdge(edge_id).from])
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+    for (EdgeId edge_id = backward.prev_edges[meeting_vertex]; edge_id != NO_EDGE;
+         edge_id = backward.prev_edges[graph_.GetEdge(edge_id).to])
+    {
+        edges.push_back(edge_id);
+    }
+
+    return RouteInfo{*best_weight, std::move(edges)};
+}
+
+}  // namespace graph
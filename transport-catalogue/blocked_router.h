@@ -0,0 +1,197 @@
+#pragma once
+
+#include "graph.h"
+#include "parallel.h"
+#include "router.h"
+#include "serialization.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace graph {
+
+// Предподсчёт всех пар вершин блочным алгоритмом Флойда–Уоршелла.
+// Веса и последние рёбра путей хранятся в двух плоских матрицах (float и uint32_t),
+// матрица обходится квадратными блоками, помещающимися в кэш, а независимые блоки
+// каждой фазы обрабатываются параллельно.
+template <typename Weight>
+class BlockedAllPairsRouter : public RouteEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using typename RouteEngine<Weight>::RouteInfo;
+
+    explicit BlockedAllPairsRouter(const Graph& graph);
+    // Восстанавливает матрицы, сохранённые методом Save, без пересчёта
+    BlockedAllPairsRouter(const Graph& graph, serialization::Reader& reader);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    void Save(serialization::Writer& writer) const override;
+
+    size_t GetMemoryUsage() const override {
+        return memory::GetHeapBytes(weights_) + memory::GetHeapBytes(prev_edges_);
+    }
+
+private:
+    using MatrixWeight = float;
+    using MatrixEdge = uint32_t;
+
+    static constexpr size_t BLOCK_SIZE = 64;
+    static constexpr MatrixWeight INFINITE_WEIGHT = std::numeric_limits<MatrixWeight>::infinity();
+    static constexpr MatrixEdge NO_MATRIX_EDGE = std::numeric_limits<MatrixEdge>::max();
+
+    size_t Index(VertexId from, VertexId to) const {
+        return from * vertex_count_ + to;
+    }
+
+    // Релаксация блока (block_row, block_col) через вершины блока block_through
+    void RelaxBlock(size_t block_row, size_t block_col, size_t block_through);
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    size_t vertex_count_;
+    size_t block_count_;
+    std::vector<MatrixWeight> weights_;
+    std::vector<MatrixEdge> prev_edges_;
+};
+
+template <typename Weight>
+BlockedAllPairsRouter<Weight>::BlockedAllPairsRouter(const Graph& graph)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , block_count_((vertex_count_ + BLOCK_SIZE - 1) / BLOCK_SIZE)
+    , weights_(vertex_count_ * vertex_count_, INFINITE_WEIGHT)
+    , prev_edges_(vertex_count_ * vertex_count_, NO_MATRIX_EDGE)
+{
+    if (graph.GetEdgeCount() >= NO_MATRIX_EDGE) {
+        throw std::length_error("Too many edges for the all-pairs matrix");
+    }
+
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        weights_[Index(vertex, vertex)] = 0;
+        for (const auto& edge : graph.GetIncidentEdges(vertex)) {
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            const MatrixWeight weight = static_cast<MatrixWeight>(edge.weight);
+            const size_t index = Index(vertex, edge.to);
+            if (weight < weights_[index]) {
+                weights_[index] = weight;
+                prev_edges_[index] = static_cast<MatrixEdge>(edge.id);
+            }
+        }
+    }
+
+    // Для каждого блока-посредника k: сначала диагональный блок (k, k), затем блоки строки
+    // и столбца k, которые зависят только от него, затем все остальные блоки
+    for (size_t k = 0; k < block_count_; ++k) {
+        RelaxBlock(k, k, k);
+
+        parallel::ForEachIndex(2 * block_count_, [this, k](size_t task) {
+            const size_t other = task / 2;
+            if (other == k) {
+                return;
+            }
+            if (task % 2 == 0) {
+                RelaxBlock(k, other, k);
+            } else {
+                RelaxBlock(other, k, k);
+            }
+        });
+
+        parallel::ForEachIndex(block_count_, [this, k](size_t block_row) {
+            if (block_row == k) {
+                return;
+            }
+            for (size_t block_col = 0; block_col < block_count_; ++block_col) {
+                if (block_col != k) {
+                    RelaxBlock(block_row, block_col, k);
+                }
+            }
+        });
+    }
+}
+
+template <typename Weight>
+BlockedAllPairsRouter<Weight>::BlockedAllPairsRouter(const Graph& graph, serialization::Reader& reader)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , block_count_((vertex_count_ + BLOCK_SIZE - 1) / BLOCK_SIZE)
+    , weights_(reader.ReadVector<MatrixWeight>())
+    , prev_edges_(reader.ReadVector<MatrixEdge>())
+{
+    if (weights_.size() != vertex_count_ * vertex_count_ || prev_edges_.size() != weights_.size()) {
+        throw std::runtime_error("Serialized all-pairs matrix does not match the graph");
+    }
+}
+
+template <typename Weight>
+void BlockedAllPairsRouter<Weight>::Save(serialization::Writer& writer) const {
+    writer.WriteVector(weights_);
+    writer.WriteVector(prev_edges_);
+}
+
+template <typename Weight>
+void BlockedAllPairsRouter<Weight>::RelaxBlock(size_t block_row, size_t block_col, size_t block_through) {
+    const size_t row_begin = block_row * BLOCK_SIZE;
+    const size_t row_end = std::min(row_begin + BLOCK_SIZE, vertex_count_);
+    const size_t col_begin = block_col * BLOCK_SIZE;
+    const size_t col_end = std::min(col_begin + BLOCK_SIZE, vertex_count_);
+    const size_t through_begin = block_through * BLOCK_SIZE;
+    const size_t through_end = std::min(through_begin + BLOCK_SIZE, vertex_count_);
+
+    for (size_t through = through_begin; through < through_end; ++through) {
+        const MatrixWeight* through_row = &weights_[Index(through, 0)];
+        const MatrixEdge* through_prev = &prev_edges_[Index(through, 0)];
+        for (size_t from = row_begin; from < row_end; ++from) {
+            const MatrixWeight weight_to_through = weights_[Index(from, through)];
+            if (weight_to_through == INFINITE_WEIGHT) {
+                continue;
+            }
+            MatrixWeight* row = &weights_[Index(from, 0)];
+            MatrixEdge* prev = &prev_edges_[Index(from, 0)];
+            for (size_t to = col_begin; to < col_end; ++to) {
+                const MatrixWeight candidate = weight_to_through + through_row[to];
+                if (candidate < row[to]) {
+                    row[to] = candidate;
+                    prev[to] = through_prev[to];
+                }
+            }
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename BlockedAllPairsRouter<Weight>::RouteInfo>
+BlockedAllPairsRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (weights_[Index(from, to)] == INFINITE_WEIGHT) {
+        return std::nullopt;
+    }
+
+    // Матрица хранит веса в float, поэтому итоговый вес суммируется по исходным рёбрам
+    Weight weight = ZERO_WEIGHT;
+    std::vector<EdgeId> edges;
+    for (MatrixEdge edge_id = prev_edges_[Index(from, to)]; edge_id != NO_MATRIX_EDGE;
+         edge_id = prev_edges_[Index(from, graph_.GetEdge(edge_id).from)])
+    {
+        if (edges.size() >= vertex_count_) {
+            throw std::logic_error("Cycle in the all-pairs predecessor matrix");
+        }
+        edges.push_back(edge_id);
+        weight += graph_.GetEdge(edge_id).weight;
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{weight, std::move(edges)};
+}
+
+}  // namespace graph
@@ -0,0 +1,477 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_state.h"
+#include "serialization.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Иерархия сжатия (Contraction Hierarchies). При построении вершины по очереди «сжимаются»:
+// кратчайшие пути через сжимаемую вершину заменяются рёбрами-сокращениями между её соседями.
+// Запрос — два поиска Дейкстры, прямой и обратный, идущие только вверх по порядку сжатия.
+template <typename Weight>
+class ContractionHierarchyRouter : public RouteEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using typename RouteEngine<Weight>::RouteInfo;
+
+    explicit ContractionHierarchyRouter(const Graph& graph);
+    // Восстанавливает иерархию, сохранённую методом Save, без повторного сжатия
+    ContractionHierarchyRouter(const Graph& graph, serialization::Reader& reader);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    void Save(serialization::Writer& writer) const override;
+
+    size_t GetMemoryUsage() const override {
+        return memory::GetHeapBytes(edges_) + memory::GetHeapBytes(upward_offsets_) + memory::GetHeapBytes(upward_edges_)
+            + memory::GetHeapBytes(downward_offsets_) + memory::GetHeapBytes(downward_edges_);
+    }
+
+    size_t GetShortcutCount() const {
+        return edges_.size() - graph_.GetEdgeCount();
+    }
+
+private:
+    // Ребро иерархии. Первые GetEdgeCount() рёбер совпадают с рёбрами графа,
+    // остальные — сокращения, составленные из рёбер first_child и second_child
+    struct HierarchyEdge {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        EdgeId first_child = NO_EDGE;
+        EdgeId second_child = NO_EDGE;
+    };
+
+    // Ребро поискового графа: сосед вершины и ребро иерархии, ведущее к нему
+    struct SearchEdge {
+        VertexId vertex;
+        Weight weight;
+        EdgeId edge_id;
+    };
+
+    struct SearchStates {
+        SearchState<Weight> forward;
+        SearchState<Weight> backward;
+    };
+
+    static SearchStates& GetSearchStates() {
+        thread_local SearchStates states;
+        return states;
+    }
+
+    class Builder;
+
+    void UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    std::vector<HierarchyEdge> edges_;
+    // Рёбра к вершинам с большим рангом: исходящие для прямого поиска
+    // и входящие для обратного, в сжатом виде по вершинам
+    std::vector<size_t> upward_offsets_;
+    std::vector<SearchEdge> upward_edges_;
+    std::vector<size_t> downward_offsets_;
+    std::vector<SearchEdge> downward_edges_;
+};
+
+// Построение иерархии: порядок сжатия выбирается по разности рёбер (число добавляемых
+// сокращений минус число удаляемых рёбер) плюс число уже сжатых соседей, приоритеты
+// пересчитываются лениво при извлечении вершины из очереди
+template <typename Weight>
+class ContractionHierarchyRouter<Weight>::Builder {
+public:
+    Builder(const Graph& graph, std::vector<HierarchyEdge>& edges)
+        : edges_(edges)
+        , outgoing_(graph.GetVertexCount())
+        , incoming_(graph.GetVertexCount())
+        , contracted_(graph.GetVertexCount(), false)
+        , contracted_neighbors_(graph.GetVertexCount(), 0)
+        , ranks_(graph.GetVertexCount(), 0)
+    {
+        const size_t edge_count = graph.GetEdgeCount();
+        edges_.reserve(edge_count);
+        for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+            const auto& edge = graph.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            edges_.push_back({edge.from, edge.to, edge.weight});
+            if (edge.from != edge.to) {
+                outgoing_[edge.from].push_back(edge_id);
+                incoming_[edge.to].push_back(edge_id);
+            }
+        }
+        witness_.Prepare(graph.GetVertexCount());
+        is_target_.assign(graph.GetVertexCount(), 0);
+    }
+
+    // Сжимает все вершины и возвращает их ранги (порядковые номера сжатия)
+    std::vector<size_t> Contract() {
+        using QueueItem = std::pair<int, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        for (VertexId vertex = 0; vertex < outgoing_.size(); ++vertex) {
+            queue.push({ComputePriority(vertex), vertex});
+        }
+
+        size_t rank = 0;
+        while (!queue.empty()) {
+            const VertexId vertex = queue.top().second;
+            queue.pop();
+            const int priority = ComputePriority(vertex);
+            if (!queue.empty() && priority > queue.top().first) {
+                queue.push({priority, vertex});
+                continue;
+            }
+            ContractVertex(vertex);
+            ranks_[vertex] = rank++;
+        }
+        return std::move(ranks_);
+    }
+
+private:
+    // Ограничения числа вершин, просматриваемых при поиске пути-свидетеля: при оценке
+    // приоритета достаточно грубой прикидки, при сжатии лишние сокращения дороже
+    static constexpr size_t PRIORITY_SETTLE_LIMIT = 50;
+    static constexpr size_t CONTRACTION_SETTLE_LIMIT = 500;
+
+    struct Shortcut {
+        EdgeId first_child;
+        EdgeId second_child;
+    };
+
+    int ComputePriority(VertexId vertex) {
+        const int shortcut_count = static_cast<int>(FindShortcuts(vertex, PRIORITY_SETTLE_LIMIT).size());
+        const int removed_count = static_cast<int>(CountActive(outgoing_[vertex], &HierarchyEdge::to)
+                                                   + CountActive(incoming_[vertex], &HierarchyEdge::from));
+        return shortcut_count - removed_count + contracted_neighbors_[vertex];
+    }
+
+    size_t CountActive(const std::vector<EdgeId>& edge_ids, VertexId HierarchyEdge::*end) const {
+        return std::count_if(edge_ids.begin(), edge_ids.end(), [this, end](EdgeId edge_id) {
+            return !contracted_[edges_[edge_id].*end];
+        });
+    }
+
+    // Находит пары рёбер u -> vertex -> w, которые нужно заменить сокращениями,
+    // поскольку без vertex между u и w нет пути не длиннее
+    std::vector<Shortcut> FindShortcuts(VertexId vertex, size_t settle_limit) {
+        std::vector<Shortcut> shortcuts;
+        for (const EdgeId in_edge_id : incoming_[vertex]) {
+            const VertexId source = edges_[in_edge_id].from;
+            if (contracted_[source]) {
+                continue;
+            }
+            Weight max_weight = ZERO_WEIGHT;
+            targets_.clear();
+            for (const EdgeId out_edge_id : outgoing_[vertex]) {
+                const VertexId target = edges_[out_edge_id].to;
+                if (!contracted_[target] && target != source) {
+                    max_weight = std::max(max_weight, edges_[in_edge_id].weight + edges_[out_edge_id].weight);
+                    targets_.push_back(target);
+                }
+            }
+            if (targets_.empty()) {
+                continue;
+            }
+
+            RunWitnessSearch(source, vertex, max_weight, settle_limit);
+            for (const EdgeId out_edge_id : outgoing_[vertex]) {
+                const VertexId target = edges_[out_edge_id].to;
+                if (contracted_[target] || target == source) {
+                    continue;
+                }
+                const Weight weight = edges_[in_edge_id].weight + edges_[out_edge_id].weight;
+                if (!witness_.IsReached(target) || weight < witness_.weights[target]) {
+                    shortcuts.push_back({in_edge_id, out_edge_id});
+                }
+            }
+        }
+        return shortcuts;
+    }
+
+    // Ограниченный поиск Дейкстры из source в ещё не сжатой части графа в обход excluded.
+    // Завершается, когда найдены расстояния до всех вершин из targets_
+    void RunWitnessSearch(VertexId source, VertexId excluded, Weight max_weight, size_t settle_limit) {
+        witness_.Prepare(outgoing_.size());
+        for (const VertexId target : targets_) {
+            is_target_[target] = witness_.stamp;
+        }
+        size_t targets_left = targets_.size();
+
+        witness_.Reach(source, ZERO_WEIGHT, NO_EDGE);
+        witness_.Push(ZERO_WEIGHT, source);
+
+        size_t settled_count = 0;
+        while (!witness_.heap.empty() && settled_count < settle_limit && targets_left > 0) {
+            const auto [weight, vertex] = witness_.Pop();
+            if (witness_.weights[vertex] < weight) {
+                continue;
+            }
+            if (weight > max_weight) {
+                break;
+            }
+            ++settled_count;
+            if (is_target_[vertex] == witness_.stamp) {
+                is_target_[vertex] = 0;
+                --targets_left;
+            }
+            for (const EdgeId edge_id : outgoing_[vertex]) {
+                const auto& edge = edges_[edge_id];
+                if (edge.to == excluded || contracted_[edge.to]) {
+                    continue;
+                }
+                const Weight candidate_weight = weight + edge.weight;
+                if (!witness_.IsReached(edge.to) || candidate_weight < witness_.weights[edge.to]) {
+                    witness_.Reach(edge.to, candidate_weight, edge_id);
+                    witness_.Push(candidate_weight, edge.to);
+                }
+            }
+        }
+    }
+
+    void ContractVertex(VertexId vertex) {
+        for (const auto [first_child, second_child] : FindShortcuts(vertex, CONTRACTION_SETTLE_LIMIT)) {
+            AddShortcut(first_child, second_child);
+        }
+
+        // Рёбра к сжатой вершине больше не участвуют в построении, убираем их из списков соседей
+        contracted_[vertex] = true;
+        const auto is_dead = [this](VertexId HierarchyEdge::*end) {
+            return [this, end](EdgeId edge_id) { return contracted_[edges_[edge_id].*end]; };
+        };
+        for (const EdgeId edge_id : outgoing_[vertex]) {
+            const VertexId neighbor = edges_[edge_id].to;
+            ++contracted_neighbors_[neighbor];
+            auto& edge_ids = incoming_[neighbor];
+            edge_ids.erase(std::remove_if(edge_ids.begin(), edge_ids.end(), is_dead(&HierarchyEdge::from)),
+                           edge_ids.end());
+        }
+        for (const EdgeId edge_id : incoming_[vertex]) {
+            const VertexId neighbor = edges_[edge_id].from;
+            ++contracted_neighbors_[neighbor];
+            auto& edge_ids = outgoing_[neighbor];
+            edge_ids.erase(std::remove_if(edge_ids.begin(), edge_ids.end(), is_dead(&HierarchyEdge::to)),
+                           edge_ids.end());
+        }
+        outgoing_[vertex] = {};
+        incoming_[vertex] = {};
+    }
+
+    // Добавляет сокращение, если между его концами ещё нет ребра не тяжелее.
+    // Более тяжёлое параллельное ребро при этом исключается из построения
+    void AddShortcut(EdgeId first_child, EdgeId second_child) {
+        const VertexId from = edges_[first_child].from;
+        const VertexId to = edges_[second_child].to;
+        const Weight weight = edges_[first_child].weight + edges_[second_child].weight;
+
+        auto& from_outgoing = outgoing_[from];
+        const auto parallel_it = std::find_if(from_outgoing.begin(), from_outgoing.end(),
+                                              [this, to](EdgeId edge_id) { return edges_[edge_id].to == to; });
+        if (parallel_it != from_outgoing.end()) {
+            const EdgeId parallel_id = *parallel_it;
+            if (edges_[parallel_id].weight <= weight) {
+                return;
+            }
+            from_outgoing.erase(parallel_it);
+            auto& to_incoming = incoming_[to];
+            to_incoming.erase(std::find(to_incoming.begin(), to_incoming.end(), parallel_id));
+        }
+
+        const EdgeId shortcut_id = edges_.size();
+        edges_.push_back({from, to, weight, first_child, second_child});
+        from_outgoing.push_back(shortcut_id);
+        incoming_[to].push_back(shortcut_id);
+    }
+
+    std::vector<HierarchyEdge>& edges_;
+    std::vector<std::vector<EdgeId>> outgoing_;
+    std::vector<std::vector<EdgeId>> incoming_;
+    std::vector<bool> contracted_;
+    std::vector<int> contracted_neighbors_;
+    std::vector<size_t> ranks_;
+    SearchState<Weight> witness_;
+    std::vector<VertexId> targets_;
+    std::vector<uint32_t> is_target_;
+};
+
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph)
+    : graph_(graph)
+{
+    const std::vector<size_t> ranks = Builder(graph, edges_).Contract();
+
+    // Раскладываем рёбра иерархии по вершинам с меньшим рангом
+    const size_t vertex_count = graph.GetVertexCount();
+    upward_offsets_.assign(vertex_count + 1, 0);
+    downward_offsets_.assign(vertex_count + 1, 0);
+    for (const auto& edge : edges_) {
+        if (edge.from == edge.to) {
+            continue;
+        }
+        if (ranks[edge.from] < ranks[edge.to]) {
+            ++upward_offsets_[edge.from + 1];
+        } else {
+            ++downward_offsets_[edge.to + 1];
+        }
+    }
+    std::partial_sum(upward_offsets_.begin(), upward_offsets_.end(), upward_offsets_.begin());
+    std::partial_sum(downward_offsets_.begin(), downward_offsets_.end(), downward_offsets_.begin());
+
+    upward_edges_.resize(upward_offsets_.back());
+    downward_edges_.resize(downward_offsets_.back());
+    std::vector<size_t> upward_positions(upward_offsets_.begin(), upward_offsets_.end() - 1);
+    std::vector<size_t> downward_positions(downward_offsets_.begin(), downward_offsets_.end() - 1);
+    for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+        const auto& edge = edges_[edge_id];
+        if (edge.from == edge.to) {
+            continue;
+        }
+        if (ranks[edge.from] < ranks[edge.to]) {
+            upward_edges_[upward_positions[edge.from]++] = {edge.to, edge.weight, edge_id};
+        } else {
+            downward_edges_[downward_positions[edge.to]++] = {edge.from, edge.weight, edge_id};
+        }
+    }
+}
+
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph, serialization::Reader& reader)
+    : graph_(graph)
+    , edges_(reader.ReadVector<HierarchyEdge>())
+    , upward_offsets_(reader.ReadVector<size_t>())
+    , upward_edges_(reader.ReadVector<SearchEdge>())
+    , downward_offsets_(reader.ReadVector<size_t>())
+    , downward_edges_(reader.ReadVector<SearchEdge>())
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    if (edges_.size() < graph.GetEdgeCount()
+        || upward_offsets_.size() != vertex_count + 1 || upward_offsets_.back() != upward_edges_.size()
+        || downward_offsets_.size() != vertex_count + 1 || downward_offsets_.back() != downward_edges_.size())
+    {
+        throw std::runtime_error("Serialized contraction hierarchy does not match the graph");
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::Save(serialization::Writer& writer) const {
+    writer.WriteVector(edges_);
+    writer.WriteVector(upward_offsets_);
+    writer.WriteVector(upward_edges_);
+    writer.WriteVector(downward_offsets_);
+    writer.WriteVector(downward_edges_);
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo>
+ContractionHierarchyRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    auto& [forward, backward] = GetSearchStates();
+    forward.Prepare(vertex_count);
+    backward.Prepare(vertex_count);
+    forward.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    forward.Push(ZERO_WEIGHT, from);
+    backward.Reach(to, ZERO_WEIGHT, NO_EDGE);
+    backward.Push(ZERO_WEIGHT, to);
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+    if (from == to) {
+        best_weight = ZERO_WEIGHT;
+    }
+
+    const auto step = [&](SearchState<Weight>& state, const SearchState<Weight>& opposite,
+                          const std::vector<size_t>& offsets, const std::vector<SearchEdge>& search_edges) {
+        const auto [weight, vertex] = state.Pop();
+        if (state.weights[vertex] < weight) {
+            return;
+        }
+        for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+            const SearchEdge& edge = search_edges[i];
+            const Weight candidate_weight = weight + edge.weight;
+            if (!state.IsReached(edge.vertex) || candidate_weight < state.weights[edge.vertex]) {
+                state.Reach(edge.vertex, candidate_weight, edge.edge_id);
+                state.Push(candidate_weight, edge.vertex);
+                if (opposite.IsReached(edge.vertex)) {
+                    const Weight weight_through = candidate_weight + opposite.weights[edge.vertex];
+                    if (!best_weight || weight_through < *best_weight) {
+                        best_weight = weight_through;
+                        meeting_vertex = edge.vertex;
+                    }
+                }
+            }
+        }
+    };
+
+    // Направление прекращает поиск, когда минимум в его куче не меньше найденного пути
+    const auto is_active = [&best_weight](const SearchState<Weight>& state) {
+        return !state.heap.empty() && (!best_weight || state.heap.front().first < *best_weight);
+    };
+    while (is_active(forward) || is_active(backward)) {
+        const bool is_forward = is_active(forward)
+            && (!is_active(backward) || forward.heap.front().first <= backward.heap.front().first);
+        if (is_forward) {
+            step(forward, backward, upward_offsets_, upward_edges_);
+        } else {
+            step(backward, forward, downward_offsets_, downward_edges_);
+        }
+    }
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> hierarchy_edges;
+    for (EdgeId edge_id = forward.prev_edges[meeting_vertex]; edge_id != NO_EDGE;
+         edge_id = forward.prev_edges[edges_[edge_id].from])
+    {
+        hierarchy_edges.push_back(edge_id);
+    }
+    std::reverse(hierarchy_edges.begin(), hierarchy_edges.end());
+    for (EdgeId edge_id = backward.prev_edges[meeting_vertex]; edge_id != NO_EDGE;
+         edge_id = backward.prev_edges[edges_[edge_id].to])
+    {
+        hierarchy_edges.push_back(edge_id);
+    }
+
+    std::vector<EdgeId> edges;
+    for (const EdgeId edge_id : hierarchy_edges) {
+        UnpackEdge(edge_id, edges);
+    }
+    return RouteInfo{*best_weight, std::move(edges)};
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const {
+    std::vector<EdgeId> stack{edge_id};
+    while (!stack.empty()) {
+        const EdgeId current = stack.back();
+        stack.pop_back();
+        const auto& edge = edges_[current];
+        if (edge.first_child == NO_EDGE) {
+            edges.push_back(current);
+        } else {
+            stack.push_back(edge.second_child);
+            stack.push_back(edge.first_child);
+        }
+    }
+}
+
+}  // namespace graph
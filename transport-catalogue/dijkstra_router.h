@@ -0,0 +1,135 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_state.h"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Поиск кратчайшего пути алгоритмом Дейкстры на каждый запрос.
+// Построение занимает O(E), память на запрос — O(V) в переиспользуемых буферах потока.
+template <typename Weight>
+class DijkstraRouter : public RouteEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using typename RouteEngine<Weight>::RouteInfo;
+
+    explicit DijkstraRouter(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    // Обход вершин в порядке возрастания веса пути от from: для каждой окончательно
+    // найденной вершины вызывается visit(vertex, weight, prev_edge). Если visit вернул
+    // false, обход прекращается. Так за один поиск считаются пути до многих вершин.
+    template <typename Visitor>
+    void ExploreFrom(VertexId from, Visitor visit) const;
+
+private:
+    static SearchState<Weight>& GetSearchState() {
+        thread_local SearchState<Weight> state;
+        return state;
+    }
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+    : graph_(graph)
+{
+    const size_t edge_count = graph.GetEdgeCount();
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo>
+DijkstraRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    SearchState<Weight>& state = GetSearchState();
+    state.Prepare(vertex_count);
+    state.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    state.Push(ZERO_WEIGHT, from);
+
+    while (!state.heap.empty()) {
+        const auto [weight, vertex] = state.Pop();
+        if (state.weights[vertex] < weight) {
+            continue;  // устаревшая запись в куче
+        }
+        if (vertex == to) {
+            break;
+        }
+
+        for (const auto& edge : graph_.GetIncidentEdges(vertex)) {
+            const Weight candidate_weight = weight + edge.weight;
+            if (!state.IsReached(edge.to) || candidate_weight < state.weights[edge.to]) {
+                state.Reach(edge.to, candidate_weight, edge.id);
+                state.Push(candidate_weight, edge.to);
+            }
+        }
+    }
+
+    if (!state.IsReached(to)) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (EdgeId edge_id = state.prev_edges[to]; edge_id != NO_EDGE;
+         edge_id = state.prev_edges[graph_.GetEdge(edge_id).from])
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{state.weights[to], std::move(edges)};
+}
+
+template <typename Weight>
+template <typename Visitor>
+void DijkstraRouter<Weight>::ExploreFrom(VertexId from, Visitor visit) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    SearchState<Weight>& state = GetSearchState();
+    state.Prepare(vertex_count);
+    state.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    state.Push(ZERO_WEIGHT, from);
+
+    while (!state.heap.empty()) {
+        const auto [weight, vertex] = state.Pop();
+        if (state.weights[vertex] < weight) {
+            continue;  // устаревшая запись в куче
+        }
+        if (!visit(vertex, weight, state.prev_edges[vertex])) {
+            return;
+        }
+
+        for (const auto& edge : graph_.GetIncidentEdges(vertex)) {
+            const Weight candidate_weight = weight + edge.weight;
+            if (!state.IsReached(edge.to) || candidate_weight < state.weights[edge.to]) {
+                state.Reach(edge.to, candidate_weight, edge.id);
+                state.Push(candidate_weight, edge.to);
+            }
+        }
+    }
+}
+
+}  // namespace graph
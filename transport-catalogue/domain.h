@@ -1,26 +1,39 @@
 #pragma once
 
 #include "geo.h"
+#include "ranges.h"
 
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <set>
 
 namespace domain {
 
+// Плотные номера остановок и автобусов в порядке добавления в каталог
+using StopId = uint32_t;
+using BusId = uint32_t;
+
+// Остановка в виде значения, собранного из столбцов каталога. Имя указывает в общую
+// строку имён каталога и действительно до следующего добавления остановки
 struct Stop {
-    std::string name;
+    std::string_view name;
     geo::Coordinates coordinates;
+    StopId id = 0;
 };
 
 struct Bus {
     std::string name;
-    std::vector<const Stop*> stops;
+    std::vector<StopId> stops;
     bool is_roundtrip = false;
+    BusId id = 0;
 };
 
+// Номера автобусов, проходящих через остановку, упорядоченные по названию.
+// Указывает во внутренний индекс каталога и действительно до его изменения
 struct StopInfo {
-    std::set<std::string> buses;
+    ranges::Range<const BusId*> buses;
 };
 
 struct BusInfo {
@@ -30,9 +43,25 @@ struct BusInfo {
     double curvature;
 };
 
+// Способ поиска маршрутов в графе TransportRouter
+enum class RouterType {
+    ALL_PAIRS, // предподсчёт всех пар вершин (Флойд–Уоршелл)
+    ALL_PAIRS_BLOCKED, // то же в плоских матрицах, блочно и на всех ядрах
+    DIJKSTRA,  // поиск Дейкстры на каждый запрос
+    ASTAR,     // двунаправленный A* с географической нижней оценкой времени
+    CONTRACTION_HIERARCHIES, // иерархия сжатия, построенная заранее
+    RAPTOR,    // поиск по раундам на последовательностях остановок, без графа
+};
+
 struct RoutingSettings {
     int bus_wait_time = 0;     // в минутах
     double bus_velocity = 0.0; // в км/ч
+    RouterType router_type = RouterType::DIJKSTRA;
+    size_t route_cache_size = 4096; // число запомненных маршрутов, 0 — без кэша
+};
+
+struct SerializationSettings {
+    std::string file; // файл с построенным роутером, пустая строка — не сохранять
 };
 
 struct RouteItem {
@@ -50,4 +79,23 @@ struct RouteResponse {
     std::string error_message;
 };
 
+// Маршруты между всеми парами из двух списков остановок: строка — откуда, столбец — куда.
+// nullopt, если маршрута нет. Маршруты целиком заполняются, только если они запрошены
+struct RouteMatrix {
+    std::vector<std::vector<std::optional<double>>> total_times;
+    std::vector<std::vector<std::optional<RouteResponse>>> routes;
+};
+
+// Остановка, до которой можно доехать не дольше заданного времени
+struct ReachableStop {
+    std::string stop_name;
+    double time = 0.0;
+};
+
+// Остановка рядом с заданной точкой
+struct NearbyStop {
+    StopId stop = 0;
+    double distance = 0.0; // в метрах
+};
+
 } // namespace domain
\ No newline at end of file
@@ -5,16 +5,30 @@
 
 namespace geo {
 
+namespace {
+
+const double dr = M_PI / 180.;
+
+} // namespace
+
+PointTerms ComputePointTerms(Coordinates point) {
+    return {std::sin(point.lat * dr), std::cos(point.lat * dr), point.lng};
+}
+
 double ComputeDistance(Coordinates from, Coordinates to) {
-    using namespace std;
     if (from == to) {
         return 0;
     }
-    static const double dr = M_PI / 180.;
-    static const int kEarthRadius = 6371000;
-    return acos(sin(from.lat * dr) * sin(to.lat * dr)
-                + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
+    return ComputeDistance(ComputePointTerms(from), ComputePointTerms(to));
+}
+
+double ComputeDistance(const PointTerms& from, const PointTerms& to) {
+    using namespace std;
+    if (from.sin_lat == to.sin_lat && from.cos_lat == to.cos_lat && from.lng == to.lng) {
+        return 0;
+    }
+    return acos(from.sin_lat * to.sin_lat + from.cos_lat * to.cos_lat * cos(abs(from.lng - to.lng) * dr))
         * kEarthRadius;
 }
 
-}  // namespace geo
\ No newline at end of file
+}  // namespace geo
@@ -2,6 +2,9 @@
 
 namespace geo {
 
+// Радиус Земли в метрах
+inline constexpr int kEarthRadius = 6371000;
+
 struct Coordinates {
     double lat; // Широта
     double lng; // Долгота
@@ -13,6 +16,19 @@ struct Coordinates {
     }
 };
 
+// Величины точки, из которых складывается формула расстояния. Для неподвижных точек,
+// например остановок, их выгодно посчитать один раз. Долгота остаётся в градусах:
+// разность долгот переводится в радианы так же, как в ComputeDistance от координат,
+// поэтому оба способа дают одинаковый результат
+struct PointTerms {
+    double sin_lat;
+    double cos_lat;
+    double lng;
+};
+
+PointTerms ComputePointTerms(Coordinates point);
+
 double ComputeDistance(Coordinates from, Coordinates to);
+double ComputeDistance(const PointTerms& from, const PointTerms& to);
 
 }  // namespace geo
\ No newline at end of file
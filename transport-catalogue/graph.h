@@ -1,8 +1,11 @@
 #pragma once
 
+#include "memory_report.h"
 #include "ranges.h"
+#include "serialization.h"
 
 #include <cstdlib>
+#include <stdexcept>
 #include <vector>
 
 namespace graph {
@@ -17,25 +20,62 @@ struct Edge {
     Weight weight;
 };
 
+// Исходящее ребро в списке смежности: конец и вес хранятся рядом с идентификатором,
+// чтобы при обходе не обращаться к общему массиву рёбер
+template <typename Weight>
+struct IncidentEdge {
+    VertexId to;
+    Weight weight;
+    EdgeId id;
+};
+
 template <typename Weight>
 class DirectedWeightedGraph {
 private:
-    using IncidenceList = std::vector<EdgeId>;
-    using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+    using IncidenceList = std::vector<IncidentEdge<Weight>>;
+    using IncidentEdgesRange = ranges::Range<const IncidentEdge<Weight>*>;
 
 public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
+    // Восстанавливает замороженный граф, сохранённый методом Save
+    explicit DirectedWeightedGraph(serialization::Reader& reader);
     EdgeId AddEdge(const Edge<Weight>& edge);
 
+    // Упаковывает списки смежности в сжатый построчный формат (CSR): исходящие рёбра
+    // всех вершин лежат подряд в одном массиве, упорядоченные по началу.
+    // После заморозки добавлять рёбра нельзя
+    void Freeze();
+    // Распаковывает CSR обратно в списки смежности, чтобы можно было снова добавлять
+    // вершины и рёбра. Идентификаторы рёбер сохраняются
+    void Thaw();
+    bool IsFrozen() const;
+
+    // Добавляет count вершин без рёбер, номера новых вершин идут следом за старыми
+    void AddVertices(size_t count);
+    // Меняет вес ребра на месте, в том числе в замороженном графе
+    void SetEdgeWeight(EdgeId edge_id, Weight weight);
+    // Удаляет рёбра с номерами [first, first + count) из замороженного графа за один
+    // проход по CSR. Номера следующих рёбер уменьшаются на count
+    void RemoveEdges(EdgeId first, size_t count);
+
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+    // Сохраняет рёбра и упакованные списки смежности, граф должен быть заморожен
+    void Save(serialization::Writer& writer) const;
+
+    size_t GetMemoryUsage() const;
+
 private:
     std::vector<Edge<Weight>> edges_;
     std::vector<IncidenceList> incidence_lists_;
+    // Замороженное представление: рёбра вершины v лежат в
+    // incident_edges_[offsets_[v] .. offsets_[v + 1])
+    std::vector<size_t> offsets_;
+    std::vector<IncidentEdge<Weight>> incident_edges_;
 };
 
 template <typename Weight>
@@ -43,17 +83,143 @@ DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
     : incidence_lists_(vertex_count) {
 }
 
+template <typename Weight>
+DirectedWeightedGraph<Weight>::DirectedWeightedGraph(serialization::Reader& reader)
+    : edges_(reader.ReadVector<Edge<Weight>>())
+    , offsets_(reader.ReadVector<size_t>())
+    , incident_edges_(reader.ReadVector<IncidentEdge<Weight>>())
+{
+    if (offsets_.empty() || offsets_.back() != incident_edges_.size() || incident_edges_.size() != edges_.size()) {
+        throw std::runtime_error("Serialized graph is inconsistent");
+    }
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::Save(serialization::Writer& writer) const {
+    if (!IsFrozen()) {
+        throw std::logic_error("Only a frozen graph can be saved");
+    }
+    writer.WriteVector(edges_);
+    writer.WriteVector(offsets_);
+    writer.WriteVector(incident_edges_);
+}
+
+template <typename Weight>
+size_t DirectedWeightedGraph<Weight>::GetMemoryUsage() const {
+    return memory::GetHeapBytes(edges_) + memory::GetHeapBytes(incidence_lists_)
+        + memory::GetHeapBytes(offsets_) + memory::GetHeapBytes(incident_edges_);
+}
+
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+    if (IsFrozen()) {
+        throw std::logic_error("Cannot add an edge to a frozen graph");
+    }
     edges_.push_back(edge);
     const EdgeId id = edges_.size() - 1;
-    incidence_lists_.at(edge.from).push_back(id);
+    incidence_lists_.at(edge.from).push_back({edge.to, edge.weight, id});
     return id;
 }
 
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::Freeze() {
+    if (IsFrozen()) {
+        return;
+    }
+    offsets_.reserve(incidence_lists_.size() + 1);
+    offsets_.push_back(0);
+    incident_edges_.reserve(edges_.size());
+    for (IncidenceList& incidence_list : incidence_lists_) {
+        incident_edges_.insert(incident_edges_.end(), incidence_list.begin(), incidence_list.end());
+        offsets_.push_back(incident_edges_.size());
+        IncidenceList{}.swap(incidence_list);
+    }
+    incidence_lists_.clear();
+    incidence_lists_.shrink_to_fit();
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::Thaw() {
+    if (!IsFrozen()) {
+        return;
+    }
+    const size_t vertex_count = offsets_.size() - 1;
+    incidence_lists_.resize(vertex_count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        incidence_lists_[vertex].assign(incident_edges_.begin() + offsets_[vertex],
+                                        incident_edges_.begin() + offsets_[vertex + 1]);
+    }
+    std::vector<size_t>{}.swap(offsets_);
+    std::vector<IncidentEdge<Weight>>{}.swap(incident_edges_);
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::AddVertices(size_t count) {
+    if (IsFrozen()) {
+        throw std::logic_error("Cannot add vertices to a frozen graph");
+    }
+    incidence_lists_.resize(incidence_lists_.size() + count);
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+    Edge<Weight>& edge = edges_.at(edge_id);
+    edge.weight = weight;
+
+    // Копия ребра в списке смежности ищется среди исходящих рёбер его начала
+    IncidentEdge<Weight>* begin = nullptr;
+    IncidentEdge<Weight>* end = nullptr;
+    if (IsFrozen()) {
+        begin = incident_edges_.data() + offsets_[edge.from];
+        end = incident_edges_.data() + offsets_[edge.from + 1];
+    } else {
+        begin = incidence_lists_[edge.from].data();
+        end = begin + incidence_lists_[edge.from].size();
+    }
+    for (IncidentEdge<Weight>* incident_edge = begin; incident_edge != end; ++incident_edge) {
+        if (incident_edge->id == edge_id) {
+            incident_edge->weight = weight;
+            return;
+        }
+    }
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::RemoveEdges(EdgeId first, size_t count) {
+    if (!IsFrozen()) {
+        throw std::logic_error("Edges can be removed only from a frozen graph");
+    }
+    const EdgeId last = first + count;
+    size_t write = 0;
+    size_t read = 0;
+    const size_t vertex_count = offsets_.size() - 1;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        const size_t end = offsets_[vertex + 1];
+        offsets_[vertex] = write;
+        for (; read < end; ++read) {
+            IncidentEdge<Weight> edge = incident_edges_[read];
+            if (edge.id >= first && edge.id < last) {
+                continue;
+            }
+            if (edge.id >= last) {
+                edge.id -= count;
+            }
+            incident_edges_[write++] = edge;
+        }
+    }
+    offsets_[vertex_count] = write;
+    incident_edges_.resize(write);
+    edges_.erase(edges_.begin() + first, edges_.begin() + last);
+}
+
+template <typename Weight>
+bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+    return !offsets_.empty();
+}
+
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-    return incidence_lists_.size();
+    return IsFrozen() ? offsets_.size() - 1 : incidence_lists_.size();
 }
 
 template <typename Weight>
@@ -69,6 +235,11 @@ const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const
 template <typename Weight>
 typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-    return ranges::AsRange(incidence_lists_.at(vertex));
+    if (IsFrozen()) {
+        const IncidentEdge<Weight>* data = incident_edges_.data();
+        return {data + offsets_.at(vertex), data + offsets_.at(vertex + 1)};
+    }
+    const IncidenceList& incidence_list = incidence_lists_.at(vertex);
+    return {incidence_list.data(), incidence_list.data() + incidence_list.size()};
 }
 }  // namespace graph
\ No newline at end of file
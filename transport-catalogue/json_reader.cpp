@@ -1,7 +1,9 @@
 #include <algorithm>
 #include <string>
 #include <iomanip>
+#include <limits>
 #include <sstream>
+#include <stdexcept>
 #include <optional>
 #include <string_view>
 
@@ -12,6 +14,45 @@ namespace json_reader {
 
 using namespace std::literals;
 
+namespace {
+
+// Оценка памяти разобранного JSON: массивы и строки по ёмкости, у словарей к ключу
+// и значению добавляется заголовок узла красно-чёрного дерева libstdc++ — цвет и три
+// указателя. json::Dict не принимает аллокатор, поэтому точно посчитать его нельзя
+size_t EstimateJsonHeapBytes(const json::Node& node) {
+    if (node.IsString()) {
+        return memory::GetHeapBytes(node.AsString());
+    }
+    size_t bytes = 0;
+    if (node.IsArray()) {
+        const json::Array& array = node.AsArray();
+        bytes += array.capacity() * sizeof(json::Node);
+        for (const json::Node& item : array) {
+            bytes += EstimateJsonHeapBytes(item);
+        }
+    } else if (node.IsMap()) {
+        for (const auto& [key, value] : node.AsMap()) {
+            bytes += 4 * sizeof(void*) + sizeof(json::Dict::value_type) + memory::GetHeapBytes(key)
+                + EstimateJsonHeapBytes(value);
+        }
+    }
+    return bytes;
+}
+
+std::string AccountingToString(memory::Accounting accounting) {
+    switch (accounting) {
+        case memory::Accounting::CAPACITY:
+            return "capacity"s;
+        case memory::Accounting::ALLOCATOR:
+            return "allocator"s;
+        case memory::Accounting::ESTIMATE:
+            return "estimate"s;
+    }
+    return {};
+}
+
+} // namespace
+
 transport::RequestHandler& JsonReader::GetRequestHandler() {
     if (!request_handler_.has_value()) {
         request_handler_.emplace(catalogue_);
@@ -37,16 +78,101 @@ void JsonReader::LoadData() {
         ParseRoutingSettings(root_map.at("routing_settings"s).AsMap());
     }
     
+    if (root_map.count("serialization_settings"s)) {
+        domain::SerializationSettings settings;
+        settings.file = root_map.at("serialization_settings"s).AsMap().at("file"s).AsString();
+        catalogue_.SetSerializationSettings(settings);
+    }
+    
     if (root_map.count("base_requests"s)) {
         ParseBaseRequests(root_map.at("base_requests"s).AsArray());
     }
-    catalogue_.BuildRouter();
+    catalogue_.Freeze();
+
+    // Роутер нужен только запросам маршрутов. Если они есть, строим его в фоне,
+    // пока обрабатываются остальные запросы, иначе он построится при первом обращении.
+    // Таблица BusInfo окупается, только если запросов автобусов много
+    if (root_map.count("stat_requests"s)) {
+        size_t bus_request_count = 0;
+        for (const auto& request_node : root_map.at("stat_requests"s).AsArray()) {
+            const std::string& type = request_node.AsMap().at("type"s).AsString();
+            if (type == "Route"s || type == "RouteMatrix"s || type == "Isochrone"s) {
+                catalogue_.BuildRouter();
+            } else if (type == "Bus"s) {
+                ++bus_request_count;
+            }
+        }
+        if (bus_request_count > 0 && bus_request_count >= catalogue_.GetAllBuses().size()) {
+            catalogue_.PrecomputeBusInfo();
+        }
+    }
+}
+
+domain::RouterType ParseRouterType(const std::string& name) {
+    if (name == "all_pairs"s) {
+        return domain::RouterType::ALL_PAIRS;
+    }
+    if (name == "all_pairs_blocked"s) {
+        return domain::RouterType::ALL_PAIRS_BLOCKED;
+    }
+    if (name == "dijkstra"s) {
+        return domain::RouterType::DIJKSTRA;
+    }
+    if (name == "astar"s) {
+        return domain::RouterType::ASTAR;
+    }
+    if (name == "contraction_hierarchies"s) {
+        return domain::RouterType::CONTRACTION_HIERARCHIES;
+    }
+    if (name == "raptor"s) {
+        return domain::RouterType::RAPTOR;
+    }
+    throw std::invalid_argument("Unknown router type: "s + name);
+}
+
+json::Array RouteItemsToJson(const std::vector<domain::RouteItem>& items) {
+    json::Array items_array;
+    for (const auto& item : items) {
+        if (item.type == "Wait") {
+            items_array.push_back(
+                json::Builder{}
+                    .StartDict()
+                        .Key("type"s).Value("Wait"s)
+                        .Key("stop_name"s).Value(item.stop_name)
+                        .Key("time"s).Value(item.time)
+                    .EndDict()
+                    .Build()
+            );
+        } else if (item.type == "Bus") {
+            items_array.push_back(
+                json::Builder{}
+                    .StartDict()
+                        .Key("type"s).Value("Bus"s)
+                        .Key("bus"s).Value(item.bus)
+                        .Key("span_count"s).Value(item.span_count)
+                        .Key("time"s).Value(item.time)
+                    .EndDict()
+                    .Build()
+            );
+        }
+    }
+    return items_array;
 }
 
 void JsonReader::ParseRoutingSettings(const json::Dict& settings_dict) {
     domain::RoutingSettings settings;
     settings.bus_wait_time = settings_dict.at("bus_wait_time"s).AsInt();
     settings.bus_velocity = settings_dict.at("bus_velocity"s).AsDouble();
+    if (settings_dict.count("router_type"s)) {
+        settings.router_type = ParseRouterType(settings_dict.at("router_type"s).AsString());
+    }
+    if (settings_dict.count("route_cache_size"s)) {
+        const int cache_size = settings_dict.at("route_cache_size"s).AsInt();
+        if (cache_size < 0) {
+            throw std::invalid_argument("route_cache_size should be non-negative"s);
+        }
+        settings.route_cache_size = static_cast<size_t>(cache_size);
+    }
     catalogue_.SetRoutingSettings(settings);
 }
 
@@ -133,41 +259,67 @@ json::Document JsonReader::ProcessRequests() {
 }
 
 void JsonReader::ParseBaseRequests(const json::Array& requests) {
-    // 1. Сначала добавляем ВСЕ остановки (без расстояний)
+    using Catalogue = transport::TransportCatalogue;
+
+    // Сначала считаем объёмы, чтобы каталог зарезервировал все индексы один раз.
+    // Пакеты ссылаются на строки документа, копируются они только в каталог
+    Catalogue::Capacity capacity;
+    size_t bus_stop_count = 0;
     for (const auto& request_node : requests) {
         const auto& request_map = request_node.AsMap();
-        if (request_map.at("type"s).AsString() == "Stop"s) {
-            std::string name = request_map.at("name"s).AsString();
-            double lat = request_map.at("latitude"s).AsDouble();
-            double lng = request_map.at("longitude"s).AsDouble();
-            catalogue_.AddStop(name, {lat, lng});
+        const std::string& type = request_map.at("type"s).AsString();
+        if (type == "Stop"s) {
+            ++capacity.stop_count;
+            capacity.stop_names_size += request_map.at("name"s).AsString().size();
+            if (request_map.count("road_distances"s)) {
+                capacity.distance_count += request_map.at("road_distances"s).AsMap().size();
+            }
+        } else if (type == "Bus"s) {
+            ++capacity.bus_count;
+            bus_stop_count += request_map.at("stops"s).AsArray().size();
         }
     }
-    
-    // 2. Теперь добавляем расстояния (все остановки уже существуют)
+    catalogue_.Reserve(capacity);
+
+    std::vector<Catalogue::StopInput> stops;
+    std::vector<Catalogue::DistanceInput> distances;
+    std::vector<Catalogue::BusInput> buses;
+    // Остановки всех автобусов подряд, автобус ссылается на свой отрезок. Место
+    // зарезервировано заранее, поэтому ссылки не портятся при добавлении
+    std::vector<std::string_view> bus_stops;
+    stops.reserve(capacity.stop_count);
+    distances.reserve(capacity.distance_count);
+    buses.reserve(capacity.bus_count);
+    bus_stops.reserve(bus_stop_count);
+
     for (const auto& request_node : requests) {
         const auto& request_map = request_node.AsMap();
-        if (request_map.at("type"s).AsString() == "Stop"s) {
-            std::string name = request_map.at("name"s).AsString();
-            
-            // Добавляем расстояния до других остановок
+        const std::string& type = request_map.at("type"s).AsString();
+        if (type == "Stop"s) {
+            const std::string& name = request_map.at("name"s).AsString();
+            double lat = request_map.at("latitude"s).AsDouble();
+            double lng = request_map.at("longitude"s).AsDouble();
+            stops.push_back({name, {lat, lng}});
             if (request_map.count("road_distances"s)) {
-                const auto& distances = request_map.at("road_distances"s).AsMap();
-                for (const auto& [to_stop, distance_node] : distances) {
-                    int distance = distance_node.AsInt();
-                    catalogue_.AddDistance(name, to_stop, distance);
+                for (const auto& [to_stop, distance_node] : request_map.at("road_distances"s).AsMap()) {
+                    distances.push_back({name, to_stop, distance_node.AsInt()});
                 }
             }
+        } else if (type == "Bus"s) {
+            const std::string_view* first_stop = bus_stops.data() + bus_stops.size();
+            for (const auto& stop_node : request_map.at("stops"s).AsArray()) {
+                bus_stops.push_back(stop_node.AsString());
+            }
+            buses.push_back({request_map.at("name"s).AsString(),
+                             {first_stop, bus_stops.data() + bus_stops.size()},
+                             request_map.at("is_roundtrip"s).AsBool()});
         }
     }
-    
-    // 3. Затем обрабатываем автобусы
-    for (const auto& request_node : requests) {
-        const auto& request_map = request_node.AsMap();
-        if (request_map.at("type"s).AsString() == "Bus"s) {
-            ParseBus(request_map);
-        }
-    }
+
+    // Расстояния добавляются, когда все остановки уже существуют, автобусы — последними
+    catalogue_.AddStops(ranges::AsSpan(stops));
+    catalogue_.AddDistances(ranges::AsSpan(distances));
+    catalogue_.AddBuses(ranges::AsSpan(buses));
 }
 
 // Новый метод только для парсинга расстояний
@@ -184,18 +336,6 @@ void JsonReader::ParseStopDistances(const json::Dict& stop_dict) {
     }
 }
 
-void JsonReader::ParseBus(const json::Dict& bus_dict) {
-    std::string name = bus_dict.at("name"s).AsString();
-    bool is_roundtrip = bus_dict.at("is_roundtrip"s).AsBool();
-    
-    std::vector<std::string> stop_names;
-    for (const auto& stop_node : bus_dict.at("stops"s).AsArray()) {
-        stop_names.push_back(stop_node.AsString());
-    }
-    
-    catalogue_.AddBus(name, stop_names, is_roundtrip);
-}
-
 json::Array JsonReader::ProcessStatRequests(const json::Array& requests) {
     json::Array responses;
     
@@ -212,6 +352,16 @@ json::Array JsonReader::ProcessStatRequests(const json::Array& requests) {
             response = ProcessMapRequest(request_map);
         } else if (type == "Route"s) {
             response = ProcessRouteRequest(request_map);
+        } else if (type == "RouteMatrix"s) {
+            response = ProcessRouteMatrixRequest(request_map);
+        } else if (type == "Isochrone"s) {
+            response = ProcessIsochroneRequest(request_map);
+        } else if (type == "StopsInRadius"s) {
+            response = ProcessStopsInRadiusRequest(request_map);
+        } else if (type == "NearestStops"s) {
+            response = ProcessNearestStopsRequest(request_map);
+        } else if (type == "MemoryReport"s) {
+            response = ProcessMemoryReportRequest(request_map);
         }
         
         responses.push_back(response);
@@ -239,37 +389,183 @@ json::Node JsonReader::ProcessRouteRequest(const json::Dict& request) {
     }
     
     // Используем Builder для успешного ответа
-    json::Array items_array;
-    for (const auto& item : route_response->items) {
-        if (item.type == "Wait") {
-            items_array.push_back(
-                json::Builder{}
-                    .StartDict()
-                        .Key("type"s).Value("Wait"s)
-                        .Key("stop_name"s).Value(item.stop_name)
-                        .Key("time"s).Value(item.time)
-                    .EndDict()
-                    .Build()
-            );
-        } else if (item.type == "Bus") {
-            items_array.push_back(
+    json::Array items_array = RouteItemsToJson(route_response->items);
+    
+    return json::Builder{}
+        .StartDict()
+            .Key("request_id"s).Value(id)
+            .Key("total_time"s).Value(route_response->total_time)
+            .Key("items"s).Value(std::move(items_array))
+        .EndDict()
+        .Build();
+}
+
+json::Node JsonReader::ProcessRouteMatrixRequest(const json::Dict& request) {
+    int id = request.at("id"s).AsInt();
+    bool with_items = request.count("with_items"s) && request.at("with_items"s).AsBool();
+    
+    std::vector<std::string_view> from;
+    for (const auto& stop_node : request.at("from"s).AsArray()) {
+        from.push_back(stop_node.AsString());
+    }
+    std::vector<std::string_view> to;
+    for (const auto& stop_node : request.at("to"s).AsArray()) {
+        to.push_back(stop_node.AsString());
+    }
+    
+    auto& request_handler = GetRequestHandler();
+    domain::RouteMatrix matrix = request_handler.GetRouteMatrix(from, to, with_items);
+    
+    // Недостижимые пары обозначаются null
+    json::Array times_array;
+    for (const auto& row : matrix.total_times) {
+        json::Array times_row;
+        for (const auto& total_time : row) {
+            times_row.push_back(total_time ? json::Node(*total_time) : json::Node(nullptr));
+        }
+        times_array.push_back(std::move(times_row));
+    }
+    
+    if (!with_items) {
+        return json::Builder{}
+            .StartDict()
+                .Key("request_id"s).Value(id)
+                .Key("total_times"s).Value(std::move(times_array))
+            .EndDict()
+            .Build();
+    }
+    
+    json::Array routes_array;
+    for (const auto& row : matrix.routes) {
+        json::Array routes_row;
+        for (const auto& route : row) {
+            if (!route) {
+                routes_row.push_back(nullptr);
+                continue;
+            }
+            routes_row.push_back(
                 json::Builder{}
                     .StartDict()
-                        .Key("type"s).Value("Bus"s)
-                        .Key("bus"s).Value(item.bus)
-                        .Key("span_count"s).Value(item.span_count)
-                        .Key("time"s).Value(item.time)
+                        .Key("total_time"s).Value(route->total_time)
+                        .Key("items"s).Value(RouteItemsToJson(route->items))
                     .EndDict()
                     .Build()
             );
         }
+        routes_array.push_back(std::move(routes_row));
     }
     
     return json::Builder{}
         .StartDict()
             .Key("request_id"s).Value(id)
-            .Key("total_time"s).Value(route_response->total_time)
-            .Key("items"s).Value(std::move(items_array))
+            .Key("total_times"s).Value(std::move(times_array))
+            .Key("routes"s).Value(std::move(routes_array))
+        .EndDict()
+        .Build();
+}
+
+json::Node JsonReader::ProcessIsochroneRequest(const json::Dict& request) {
+    std::string from = request.at("from"s).AsString();
+    double max_time = request.at("max_time"s).AsDouble();
+    int id = request.at("id"s).AsInt();
+    
+    auto& request_handler = GetRequestHandler();
+    auto reachable_stops = request_handler.GetReachableStops(from, max_time);
+    
+    if (!reachable_stops) {
+        return json::Builder{}
+            .StartDict()
+                .Key("request_id"s).Value(id)
+                .Key("error_message"s).Value("not found"s)
+            .EndDict()
+            .Build();
+    }
+    
+    json::Array stops_array;
+    for (const auto& stop : *reachable_stops) {
+        stops_array.push_back(
+            json::Builder{}
+                .StartDict()
+                    .Key("stop_name"s).Value(stop.stop_name)
+                    .Key("time"s).Value(stop.time)
+                .EndDict()
+                .Build()
+        );
+    }
+    
+    return json::Builder{}
+        .StartDict()
+            .Key("request_id"s).Value(id)
+            .Key("stops"s).Value(std::move(stops_array))
+        .EndDict()
+        .Build();
+}
+
+json::Node JsonReader::ProcessStopsInRadiusRequest(const json::Dict& request) {
+    geo::Coordinates center{request.at("latitude"s).AsDouble(), request.at("longitude"s).AsDouble()};
+    double radius = request.at("radius"s).AsDouble();
+    int id = request.at("id"s).AsInt();
+    
+    auto& request_handler = GetRequestHandler();
+    return NearbyStopsToJson(id, request_handler.GetStopsInRadius(center, radius));
+}
+
+json::Node JsonReader::ProcessNearestStopsRequest(const json::Dict& request) {
+    geo::Coordinates center{request.at("latitude"s).AsDouble(), request.at("longitude"s).AsDouble()};
+    int count = request.at("count"s).AsInt();
+    int id = request.at("id"s).AsInt();
+    
+    auto& request_handler = GetRequestHandler();
+    return NearbyStopsToJson(id, request_handler.GetNearestStops(center, static_cast<size_t>(std::max(count, 0))));
+}
+
+json::Node JsonReader::ProcessMemoryReportRequest(const json::Dict& request) {
+    int id = request.at("id"s).AsInt();
+
+    auto& request_handler = GetRequestHandler();
+    memory::MemoryReport report = request_handler.GetMemoryReport();
+    report.Add("json_document"s, EstimateJsonHeapBytes(input_doc_.GetRoot()), memory::Accounting::ESTIMATE);
+
+    // Объём больше int выводится числом с плавающей точкой
+    const auto to_node = [](size_t bytes) {
+        return bytes <= static_cast<size_t>(std::numeric_limits<int>::max())
+            ? json::Node(static_cast<int>(bytes)) : json::Node(static_cast<double>(bytes));
+    };
+    // Способы подсчёта различаются по структурам, поэтому способ выводится рядом с объёмом
+    json::Dict structures;
+    json::Dict accounting;
+    for (const memory::MemoryReport::Item& item : report.GetItems()) {
+        structures.emplace(item.name, to_node(item.bytes));
+        accounting.emplace(item.name, AccountingToString(item.accounting));
+    }
+
+    return json::Builder{}
+        .StartDict()
+            .Key("request_id"s).Value(id)
+            .Key("total_bytes"s).Value(to_node(report.GetTotal()))
+            .Key("structures"s).Value(std::move(structures))
+            .Key("accounting"s).Value(std::move(accounting))
+        .EndDict()
+        .Build();
+}
+
+json::Node JsonReader::NearbyStopsToJson(int id, const std::vector<domain::NearbyStop>& stops) const {
+    json::Array stops_array;
+    for (const auto& stop : stops) {
+        stops_array.push_back(
+            json::Builder{}
+                .StartDict()
+                    .Key("stop_name"s).Value(std::string(catalogue_.GetStopName(stop.stop)))
+                    .Key("distance"s).Value(stop.distance)
+                .EndDict()
+                .Build()
+        );
+    }
+    
+    return json::Builder{}
+        .StartDict()
+            .Key("request_id"s).Value(id)
+            .Key("stops"s).Value(std::move(stops_array))
         .EndDict()
         .Build();
 }
@@ -320,15 +616,10 @@ json::Node JsonReader::ProcessStopRequest(const json::Dict& request) {
             .Build();
     }
     
-    std::vector<std::string> buses_sorted;
-    for (const auto& bus_name : stop_info->buses) {
-        buses_sorted.push_back(std::string(bus_name));
-    }
-    std::sort(buses_sorted.begin(), buses_sorted.end());
-    
+    // Каталог отдаёт автобусы уже упорядоченными по названию
     json::Array buses_array;
-    for (const auto& bus_name : buses_sorted) {
-        buses_array.push_back(bus_name);
+    for (domain::BusId bus : stop_info->buses) {
+        buses_array.push_back(catalogue_.GetBus(bus)->name);
     }
     
     // Используем Builder для успешного ответа
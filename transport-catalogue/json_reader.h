@@ -37,7 +37,6 @@ private:
     void ParseRoutingSettings(const json::Dict& settings_dict);
     void ParseBaseRequests(const json::Array& requests);
     void ParseStopDistances(const json::Dict& stop_dict);
-    void ParseBus(const json::Dict& bus_dict);
     
     json::Array ProcessStatRequests(const json::Array& requests);
     json::Node ProcessBusRequest(const json::Dict& request);
@@ -45,6 +44,12 @@ private:
     json::Node ProcessMapRequest(const json::Dict& request);
     
     json::Node ProcessRouteRequest(const json::Dict& request);
+    json::Node ProcessRouteMatrixRequest(const json::Dict& request);
+    json::Node ProcessIsochroneRequest(const json::Dict& request);
+    json::Node ProcessStopsInRadiusRequest(const json::Dict& request);
+    json::Node ProcessNearestStopsRequest(const json::Dict& request);
+    json::Node NearbyStopsToJson(int id, const std::vector<domain::NearbyStop>& stops) const;
+    json::Node ProcessMemoryReportRequest(const json::Dict& request);
 
     transport::TransportCatalogue catalogue_;
     json::Document input_doc_;
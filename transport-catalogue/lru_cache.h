@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cache {
+
+struct CacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+};
+
+// Потокобезопасный кэш с вытеснением давно не использованных записей (LRU).
+// Ключи распределяются по независимым сегментам со своими мьютексами,
+// чтобы параллельные запросы к разным ключам не ждали друг друга.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity, size_t shard_count = 16)
+        : shards_(std::max<size_t>(1, std::min(shard_count, capacity)))
+    {
+        const size_t shard_capacity = (capacity + shards_.size() - 1) / shards_.size();
+        for (Shard& shard : shards_) {
+            shard.capacity = capacity == 0 ? 0 : shard_capacity;
+        }
+    }
+
+    std::optional<Value> Find(const Key& key) {
+        Shard& shard = GetShard(key);
+        std::lock_guard guard(shard.mutex);
+        const auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            ++misses_;
+            return std::nullopt;
+        }
+        ++hits_;
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return it->second->second;
+    }
+
+    void Insert(const Key& key, Value value) {
+        Shard& shard = GetShard(key);
+        if (shard.capacity == 0) {
+            return;
+        }
+        std::lock_guard guard(shard.mutex);
+        if (const auto it = shard.index.find(key); it != shard.index.end()) {
+            it->second->second = std::move(value);
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return;
+        }
+        shard.entries.emplace_front(key, std::move(value));
+        shard.index[key] = shard.entries.begin();
+        if (shard.entries.size() > shard.capacity) {
+            shard.index.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+        }
+    }
+
+    void Clear() {
+        for (Shard& shard : shards_) {
+            std::lock_guard guard(shard.mutex);
+            shard.entries.clear();
+            shard.index.clear();
+        }
+    }
+
+    CacheStats GetStats() const {
+        return {hits_.load(), misses_.load()};
+    }
+
+private:
+    using Entries = std::list<std::pair<Key, Value>>;
+
+    struct Shard {
+        std::mutex mutex;
+        Entries entries;
+        std::unordered_map<Key, typename Entries::iterator, Hash> index;
+        size_t capacity = 0;
+    };
+
+    Shard& GetShard(const Key& key) {
+        return shards_[MixHash(Hash{}(key)) % shards_.size()];
+    }
+
+    // Финализатор splitmix64: std::hash целых — тождественная функция, и без
+    // перемешивания сегмент определялся бы только младшими битами ключа
+    static uint64_t MixHash(uint64_t hash) {
+        hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+        hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+        return hash ^ (hash >> 31);
+    }
+
+    std::vector<Shard> shards_;
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+};
+
+} // namespace cache
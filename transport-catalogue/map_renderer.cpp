@@ -9,31 +9,34 @@ using namespace std;
 svg::Document MapRenderer::RenderMap(const transport::TransportCatalogue& catalogue) const {
     svg::Document doc;
     
-    auto buses = catalogue.GetAllBusesSorted();
-    auto stops = catalogue.GetStopsUsedInRoutes();
+    // Каталог хранит автобусы и остановки упорядоченными по названию
+    const auto buses = catalogue.GetAllBusesSorted();
+    const auto stops = catalogue.GetStopsUsedInRoutes();
     
     vector<geo::Coordinates> geo_coords;
-    for (const auto& stop : stops) {
-        geo_coords.push_back(stop->coordinates);
+    for (domain::StopId stop : stops) {
+        geo_coords.push_back(catalogue.GetStopCoordinates(stop));
     }
     
     SphereProjector projector(geo_coords.begin(), geo_coords.end(), 
                              settings_.width, settings_.height, settings_.padding);
     
-    RenderBusLines(doc, buses, projector);
-    RenderBusLabels(doc, buses, projector);
-    RenderStopPoints(doc, stops, projector);
-    RenderStopLabels(doc, stops, projector);
+    RenderBusLines(doc, catalogue, buses, projector);
+    RenderBusLabels(doc, catalogue, buses, projector);
+    RenderStopPoints(doc, catalogue, stops, projector);
+    RenderStopLabels(doc, catalogue, stops, projector);
     
     return doc;
 }
 
 void MapRenderer::RenderBusLines(svg::Document& doc, 
-                                const std::vector<const domain::Bus*>& buses,
+                                const transport::TransportCatalogue& catalogue,
+                                ranges::Range<const domain::BusId*> buses,
                                 const SphereProjector& projector) const {
     size_t color_index = 0;
     
-    for (const auto& bus : buses) {
+    for (domain::BusId bus_id : buses) {
+        const domain::Bus* bus = catalogue.GetBus(bus_id);
         if (bus->stops.size() < 2) {
             continue;
         }
@@ -43,18 +46,18 @@ void MapRenderer::RenderBusLines(svg::Document& doc,
         
         if (bus->is_roundtrip) {
             // Кольцевой маршрут - рисуем все остановки
-            for (const auto& stop : bus->stops) {
-                polyline.AddPoint(projector(stop->coordinates));
+            for (domain::StopId stop : bus->stops) {
+                polyline.AddPoint(projector(catalogue.GetStopCoordinates(stop)));
             }
         } else {
             // Некольцевой маршрут - рисуем прямой + обратный путь
             // Прямой путь
-            for (const auto& stop : bus->stops) {
-                polyline.AddPoint(projector(stop->coordinates));
+            for (domain::StopId stop : bus->stops) {
+                polyline.AddPoint(projector(catalogue.GetStopCoordinates(stop)));
             }
             // Обратный путь (кроме последней остановки, чтобы не дублировать)
             for (auto it = bus->stops.rbegin() + 1; it != bus->stops.rend(); ++it) {
-                polyline.AddPoint(projector((*it)->coordinates));
+                polyline.AddPoint(projector(catalogue.GetStopCoordinates(*it)));
             }
         }
         
@@ -70,18 +73,20 @@ void MapRenderer::RenderBusLines(svg::Document& doc,
 }
 
 void MapRenderer::RenderBusLabels(svg::Document& doc,
-                                 const std::vector<const domain::Bus*>& buses,
+                                 const transport::TransportCatalogue& catalogue,
+                                 ranges::Range<const domain::BusId*> buses,
                                  const SphereProjector& projector) const {
     size_t color_index = 0;
     
-    for (const auto& bus : buses) {
+    for (domain::BusId bus_id : buses) {
+        const domain::Bus* bus = catalogue.GetBus(bus_id);
         if (bus->stops.empty()) {
             continue;
         }
         
         const std::string& color = settings_.color_palette[color_index % settings_.color_palette.size()];
         
-        vector<const domain::Stop*> terminal_stops;
+        vector<domain::StopId> terminal_stops;
         
         if (bus->is_roundtrip) {
             terminal_stops.push_back(bus->stops.front());
@@ -92,8 +97,8 @@ void MapRenderer::RenderBusLabels(svg::Document& doc,
             }
         }
         
-        for (const auto& stop : terminal_stops) {
-            svg::Point point = projector(stop->coordinates);
+        for (domain::StopId stop : terminal_stops) {
+            svg::Point point = projector(catalogue.GetStopCoordinates(stop));
             
             svg::Text underlayer;
             underlayer.SetPosition(point)
@@ -126,17 +131,11 @@ void MapRenderer::RenderBusLabels(svg::Document& doc,
 }
 
 void MapRenderer::RenderStopPoints(svg::Document& doc,
-                                  const std::vector<const domain::Stop*>& stops,
+                                  const transport::TransportCatalogue& catalogue,
+                                  ranges::Range<const domain::StopId*> stops,
                                   const SphereProjector& projector) const {
-    // Создаем копию и сортируем остановки по имени
-    std::vector<const domain::Stop*> sorted_stops = stops;
-    std::sort(sorted_stops.begin(), sorted_stops.end(), 
-              [](const domain::Stop* lhs, const domain::Stop* rhs) {
-                  return lhs->name < rhs->name;
-              });
-    
-    for (const auto& stop : sorted_stops) {
-        svg::Point point = projector(stop->coordinates);
+    for (domain::StopId stop : stops) {
+        svg::Point point = projector(catalogue.GetStopCoordinates(stop));
         
         svg::Circle circle;
         circle.SetCenter(point)
@@ -148,17 +147,12 @@ void MapRenderer::RenderStopPoints(svg::Document& doc,
 }
 
 void MapRenderer::RenderStopLabels(svg::Document& doc,
-                                  const std::vector<const domain::Stop*>& stops,
+                                  const transport::TransportCatalogue& catalogue,
+                                  ranges::Range<const domain::StopId*> stops,
                                   const SphereProjector& projector) const {
-    // Создаем копию и сортируем остановки по имени
-    std::vector<const domain::Stop*> sorted_stops = stops;
-    std::sort(sorted_stops.begin(), sorted_stops.end(), 
-              [](const domain::Stop* lhs, const domain::Stop* rhs) {
-                  return lhs->name < rhs->name;
-              });
-    
-    for (const auto& stop : sorted_stops) {
-        svg::Point point = projector(stop->coordinates);
+    for (domain::StopId stop : stops) {
+        const std::string stop_name(catalogue.GetStopName(stop));
+        svg::Point point = projector(catalogue.GetStopCoordinates(stop));
         
         // Подложка
         svg::Text underlayer;
@@ -166,7 +160,7 @@ void MapRenderer::RenderStopLabels(svg::Document& doc,
                  .SetOffset(settings_.stop_label_offset)
                  .SetFontSize(settings_.stop_label_font_size)
                  .SetFontFamily(settings_.font_family)
-                 .SetData(stop->name)
+                 .SetData(stop_name)
                  .SetFillColor(settings_.underlayer_color)
                  .SetStrokeColor(settings_.underlayer_color)
                  .SetStrokeWidth(settings_.underlayer_width)
@@ -179,7 +173,7 @@ void MapRenderer::RenderStopLabels(svg::Document& doc,
             .SetOffset(settings_.stop_label_offset)
             .SetFontSize(settings_.stop_label_font_size)
             .SetFontFamily(settings_.font_family)
-            .SetData(stop->name)
+            .SetData(stop_name)
             .SetFillColor("black");
         
         doc.Add(underlayer);
@@ -104,19 +104,23 @@ private:
     RenderSettings settings_;
     
     void RenderBusLines(svg::Document& doc, 
-                       const std::vector<const domain::Bus*>& buses,
+                       const transport::TransportCatalogue& catalogue,
+                       ranges::Range<const domain::BusId*> buses,
                        const SphereProjector& projector) const;
     
     void RenderBusLabels(svg::Document& doc,
-                        const std::vector<const domain::Bus*>& buses,
+                        const transport::TransportCatalogue& catalogue,
+                        ranges::Range<const domain::BusId*> buses,
                         const SphereProjector& projector) const;
     
     void RenderStopPoints(svg::Document& doc,
-                         const std::vector<const domain::Stop*>& stops,
+                         const transport::TransportCatalogue& catalogue,
+                         ranges::Range<const domain::StopId*> stops,
                          const SphereProjector& projector) const;
     
     void RenderStopLabels(svg::Document& doc,
-                         const std::vector<const domain::Stop*>& stops,
+                         const transport::TransportCatalogue& catalogue,
+                         ranges::Range<const domain::StopId*> stops,
                          const SphereProjector& projector) const;
 };
 
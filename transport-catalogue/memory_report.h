@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace memory {
+
+// Как получен объём структуры
+enum class Accounting {
+    CAPACITY,  // массивы и строки по ёмкости — ровно то, что они запросили у аллокатора
+    ALLOCATOR, // узловые контейнеры по счёту CountingAllocator, массивы в них по ёмкости
+    ESTIMATE,  // оценка по устройству узлов libstdc++: контейнер не принимает аллокатор
+};
+
+// Байты в куче, занятые структурами, по их названиям в порядке добавления
+class MemoryReport {
+public:
+    struct Item {
+        std::string name;
+        size_t bytes;
+        Accounting accounting;
+    };
+
+    void Add(std::string name, size_t bytes, Accounting accounting = Accounting::CAPACITY) {
+        items_.push_back({std::move(name), bytes, accounting});
+    }
+
+    const std::vector<Item>& GetItems() const {
+        return items_;
+    }
+
+    size_t GetTotal() const {
+        size_t total = 0;
+        for (const Item& item : items_) {
+            total += item.bytes;
+        }
+        return total;
+    }
+
+private:
+    std::vector<Item> items_;
+};
+
+// Аллокатор, который ведёт счёт байт, выделенных контейнером. Узловые контейнеры
+// выделяют узлы, корзины и блоки через перепривязанную копию аллокатора, поэтому
+// в счёт попадает всё, что они держат в куче. Счётчик принадлежит владельцу
+// контейнера и должен жить дольше него. Копия контейнера по умолчанию получает
+// аллокатор оригинала, поэтому владелец копии передаёт ей свой счётчик явно
+template <typename T>
+class CountingAllocator {
+public:
+    using value_type = T;
+
+    explicit CountingAllocator(size_t* counter) noexcept
+        : counter_(counter) {
+    }
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) noexcept
+        : counter_(other.GetCounter()) {
+    }
+
+    T* allocate(size_t count) {
+        T* result = std::allocator<T>{}.allocate(count);
+        *counter_ += count * sizeof(T);
+        return result;
+    }
+
+    void deallocate(T* pointer, size_t count) noexcept {
+        *counter_ -= count * sizeof(T);
+        std::allocator<T>{}.deallocate(pointer, count);
+    }
+
+    size_t* GetCounter() const noexcept {
+        return counter_;
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U>& other) const noexcept {
+        return counter_ == other.GetCounter();
+    }
+
+    template <typename U>
+    bool operator!=(const CountingAllocator<U>& other) const noexcept {
+        return counter_ != other.GetCounter();
+    }
+
+private:
+    size_t* counter_;
+};
+
+template <typename T>
+using CountedDeque = std::deque<T, CountingAllocator<T>>;
+
+template <typename Key, typename Value>
+using CountedHashMap = std::unordered_map<Key, Value, std::hash<Key>, std::equal_to<Key>,
+                                          CountingAllocator<std::pair<const Key, Value>>>;
+
+// Память в куче у массивов и строк — их ёмкость: ровно столько они запрашивают
+// у аллокатора. Вложенные массивы и строки учитываются рекурсивно. Узловые
+// контейнеры так не посчитать, их память ведёт CountingAllocator
+template <typename T>
+std::enable_if_t<std::is_trivially_copyable_v<T>, size_t> GetHeapBytes(const T&);
+inline size_t GetHeapBytes(const std::string& value);
+template <typename T>
+size_t GetHeapBytes(const std::vector<T>& values);
+template <typename First, typename Second>
+size_t GetHeapBytes(const std::pair<First, Second>& value);
+
+template <typename T>
+std::enable_if_t<std::is_trivially_copyable_v<T>, size_t> GetHeapBytes(const T&) {
+    return 0;
+}
+
+inline size_t GetHeapBytes(const std::string& value) {
+    // Короткие строки хранятся внутри объекта
+    return value.capacity() > std::string().capacity() ? value.capacity() + 1 : 0;
+}
+
+template <typename T>
+size_t GetHeapBytes(const std::vector<T>& values) {
+    size_t bytes = values.capacity() * sizeof(T);
+    if constexpr (!std::is_trivially_copyable_v<T>) {
+        for (const T& value : values) {
+            bytes += GetHeapBytes(value);
+        }
+    }
+    return bytes;
+}
+
+template <typename First, typename Second>
+size_t GetHeapBytes(const std::pair<First, Second>& value) {
+    return GetHeapBytes(value.first) + GetHeapBytes(value.second);
+}
+
+} // namespace memory
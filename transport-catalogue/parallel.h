@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+// Число рабочих потоков для count независимых задач
+inline size_t GetThreadCount(size_t count) {
+    const size_t hardware_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    return std::min(hardware_threads, count);
+}
+
+// Вызывает func(i) для каждого i из [0, count) на нескольких потоках. Индексы раздаются
+// по одному, поэтому задачи разной длины распределяются равномерно. Первое исключение
+// из func пробрасывается вызывающему после завершения всех потоков.
+template <typename Func>
+void ForEachIndex(size_t count, Func func) {
+    const size_t thread_count = GetThreadCount(count);
+    if (thread_count <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next_index{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    const auto worker = [&]() {
+        try {
+            for (size_t i = next_index++; i < count; i = next_index++) {
+                func(i);
+            }
+        } catch (...) {
+            std::lock_guard guard(error_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            next_index = count;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (size_t i = 1; i < thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace parallel
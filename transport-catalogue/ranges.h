@@ -4,6 +4,7 @@
 #include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace ranges {
 
@@ -33,4 +34,10 @@ auto AsRange(const C& container) {
     return Range{container.begin(), container.end()};
 }
 
+// Непрерывный массив вектора как Range указателей
+template <typename T>
+Range<const T*> AsSpan(const std::vector<T>& values) {
+    return {values.data(), values.data() + values.size()};
+}
+
 }  // namespace ranges
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <limits>
+
+#include "raptor_router.h"
+#include "transport_catalogue.h"
+
+namespace transport {
+
+using namespace std;
+
+namespace {
+
+constexpr double INFINITE_TIME = numeric_limits<double>::infinity();
+constexpr size_t NO_POSITION = numeric_limits<size_t>::max();
+
+} // namespace
+
+RaptorRouter::RaptorRouter(const TransportCatalogue& catalogue,
+                           const domain::RoutingSettings& settings)
+    : catalogue_(catalogue)
+    , settings_(settings)
+    , speed_(settings.bus_velocity * 1000.0 / 60.0) {
+    stop_count_ = catalogue_.GetStopsCount();
+    stop_patterns_.resize(stop_count_);
+
+    const auto bus_count = static_cast<domain::BusId>(catalogue_.GetBusesCount());
+    for (domain::BusId bus_id = 0; bus_id < bus_count; ++bus_id) {
+        const domain::Bus* bus = catalogue_.GetBus(bus_id);
+        AddPattern(bus, bus->stops);
+        // Некольцевой маршрут проходится и в обратную сторону
+        if (!bus->is_roundtrip) {
+            AddPattern(bus, {bus->stops.rbegin(), bus->stops.rend()});
+        }
+    }
+}
+
+void RaptorRouter::AddPattern(const domain::Bus* bus, vector<domain::StopId> stops) {
+    if (stops.size() < 2) {
+        return;
+    }
+
+    Pattern pattern;
+    pattern.bus = bus;
+    pattern.stops.reserve(stops.size());
+    pattern.distances.reserve(stops.size());
+
+    double distance = 0.0;
+    for (size_t i = 0; i < stops.size(); ++i) {
+        if (i > 0) {
+            distance += catalogue_.GetDistanceBetween(stops[i - 1], stops[i]);
+        }
+        const size_t stop_index = stops[i];
+        pattern.stops.push_back(stop_index);
+        pattern.distances.push_back(distance);
+        stop_patterns_[stop_index].push_back({patterns_.size(), i});
+    }
+    patterns_.push_back(move(pattern));
+}
+
+double RaptorRouter::GetTravelTime(const Pattern& pattern, size_t from_position, size_t to_position) const {
+    return (pattern.distances[to_position] - pattern.distances[from_position]) / speed_;
+}
+
+size_t RaptorRouter::GetMemoryUsage() const {
+    size_t bytes = patterns_.capacity() * sizeof(Pattern) + memory::GetHeapBytes(stop_patterns_);
+    for (const Pattern& pattern : patterns_) {
+        bytes += memory::GetHeapBytes(pattern.stops) + memory::GetHeapBytes(pattern.distances);
+    }
+    return bytes;
+}
+
+optional<domain::RouteResponse> RaptorRouter::FindRoute(domain::StopId from, domain::StopId to) const {
+    if (from >= stop_count_ || to >= stop_count_) {
+        return nullopt;
+    }
+    const size_t source = from;
+    const size_t target = to;
+
+    const SearchResult result = Search(source, target, INFINITE_TIME);
+    if (result.best_arrivals[target] == INFINITE_TIME) {
+        return nullopt;
+    }
+    return MakeResponse(result, source, target);
+}
+
+vector<optional<domain::RouteResponse>> RaptorRouter::FindRoutes(
+    domain::StopId from, const vector<optional<domain::StopId>>& to, bool with_items) const {
+    vector<optional<domain::RouteResponse>> responses(to.size());
+    if (from >= stop_count_) {
+        return responses;
+    }
+    const size_t source = from;
+
+    const SearchResult result = Search(source, NO_STOP, INFINITE_TIME);
+    for (size_t i = 0; i < to.size(); ++i) {
+        if (!to[i] || *to[i] >= stop_count_ || result.best_arrivals[*to[i]] == INFINITE_TIME) {
+            continue;
+        }
+        if (with_items) {
+            responses[i] = MakeResponse(result, source, *to[i]);
+        } else {
+            responses[i].emplace().total_time = result.best_arrivals[*to[i]];
+        }
+    }
+    return responses;
+}
+
+vector<pair<domain::StopId, double>> RaptorRouter::FindReachableStops(domain::StopId from, double max_time) const {
+    vector<pair<domain::StopId, double>> reachable;
+    if (from >= stop_count_ || max_time < 0.0) {
+        return reachable;
+    }
+
+    const SearchResult result = Search(from, NO_STOP, max_time);
+    for (size_t stop = 0; stop < stop_count_; ++stop) {
+        if (result.best_arrivals[stop] <= max_time) {
+            reachable.emplace_back(static_cast<domain::StopId>(stop), result.best_arrivals[stop]);
+        }
+    }
+    return reachable;
+}
+
+RaptorRouter::SearchResult RaptorRouter::Search(size_t source, size_t target, double time_limit) const {
+    const double wait_time = settings_.bus_wait_time;
+
+    // Число посадок не ограничено, поэтому раунды работают с одним массивом времён:
+    // улучшение, найденное в раунде, сразу доступно следующим направлениям того же раунда.
+    // parents[s] — как получено текущее время прибытия на s
+    SearchResult result;
+    vector<double>& best_arrivals = result.best_arrivals;
+    vector<optional<Arrival>>& parents = result.parents;
+    parents.resize(stop_count_);
+    best_arrivals.assign(stop_count_, INFINITE_TIME);
+    best_arrivals[source] = 0.0;
+
+    // Без цели отсечение по её времени прибытия не действует
+    const auto target_arrival = [&best_arrivals, target]() {
+        return target == NO_STOP ? INFINITE_TIME : best_arrivals[target];
+    };
+
+    vector<size_t> marked_stops{source};
+    vector<size_t> first_marked_positions(patterns_.size(), NO_POSITION);
+    vector<size_t> queued_patterns;
+
+    while (!marked_stops.empty()) {
+        // Направления, проходящие через остановки, улучшенные в прошлом раунде,
+        // просматриваем начиная с самой ранней такой остановки
+        queued_patterns.clear();
+        for (const size_t stop : marked_stops) {
+            for (const auto [pattern, position] : stop_patterns_[stop]) {
+                if (first_marked_positions[pattern] == NO_POSITION) {
+                    queued_patterns.push_back(pattern);
+                }
+                first_marked_positions[pattern] = min(first_marked_positions[pattern], position);
+            }
+        }
+        marked_stops.clear();
+
+        for (const size_t pattern_index : queued_patterns) {
+            const Pattern& pattern = patterns_[pattern_index];
+            // Время на посадке складывается с перегоном в том же порядке, что и веса рёбер
+            // графа: (прибытие + ожидание) + время в пути. Посадка выбирается по тому,
+            // насколько раньше с неё можно было бы выехать с начала направления
+            double board_time = INFINITE_TIME;
+            double board_key = INFINITE_TIME;
+            size_t board_position = NO_POSITION;
+            for (size_t i = first_marked_positions[pattern_index]; i < pattern.stops.size(); ++i) {
+                const size_t stop = pattern.stops[i];
+                if (board_position != NO_POSITION) {
+                    const double arrival = board_time + GetTravelTime(pattern, board_position, i);
+                    if (arrival < best_arrivals[stop] && arrival < target_arrival() && arrival <= time_limit) {
+                        best_arrivals[stop] = arrival;
+                        parents[stop] = Arrival{pattern_index, board_position, i};
+                        marked_stops.push_back(stop);
+                    }
+                }
+                const double candidate_board_time = best_arrivals[stop] + wait_time;
+                const double candidate_key = candidate_board_time - pattern.distances[i] / speed_;
+                if (candidate_key < board_key) {
+                    board_time = candidate_board_time;
+                    board_key = candidate_key;
+                    board_position = i;
+                }
+            }
+            first_marked_positions[pattern_index] = NO_POSITION;
+        }
+
+        sort(marked_stops.begin(), marked_stops.end());
+        marked_stops.erase(unique(marked_stops.begin(), marked_stops.end()), marked_stops.end());
+    }
+
+    return result;
+}
+
+domain::RouteResponse RaptorRouter::MakeResponse(const SearchResult& result, size_t source, size_t target) const {
+    const auto& parents = result.parents;
+    domain::RouteResponse response;
+    response.total_time = result.best_arrivals[target];
+
+    // Восстанавливаем поездки с конца по последним улучшениям остановок
+    vector<domain::RouteItem> items;
+    size_t stop = target;
+    while (stop != source) {
+        const Arrival& arrival = *parents[stop];
+        const Pattern& pattern = patterns_[arrival.pattern];
+
+        domain::RouteItem bus_item;
+        bus_item.type = "Bus";
+        bus_item.bus = pattern.bus->name;
+        bus_item.span_count = static_cast<int>(arrival.alight_position - arrival.board_position);
+        bus_item.time = GetTravelTime(pattern, arrival.board_position, arrival.alight_position);
+        items.push_back(move(bus_item));
+
+        stop = pattern.stops[arrival.board_position];
+        domain::RouteItem wait_item;
+        wait_item.type = "Wait";
+        wait_item.stop_name = catalogue_.GetStopName(static_cast<domain::StopId>(stop));
+        wait_item.time = settings_.bus_wait_time;
+        items.push_back(move(wait_item));
+    }
+    response.items.assign(make_move_iterator(items.rbegin()), make_move_iterator(items.rend()));
+
+    return response;
+}
+
+} // namespace transport
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "domain.h"
+#include "memory_report.h"
+
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace transport {
+
+class TransportCatalogue;
+
+// Поиск маршрутов в духе RAPTOR: вместо графа со всеми парами остановок маршрута
+// перебираются последовательности остановок автобусов по раундам, раунд k даёт
+// наилучшее время прибытия не более чем с k посадками. Каждая посадка стоит bus_wait_time.
+// Память линейна по суммарной длине маршрутов. Остановки нумеруются так же, как в каталоге.
+class RaptorRouter {
+public:
+    RaptorRouter(const TransportCatalogue& catalogue, const domain::RoutingSettings& settings);
+
+    std::optional<domain::RouteResponse> FindRoute(domain::StopId from, domain::StopId to) const;
+
+    // Один поиск от from до всех остановок сразу. Элемент i — время до to[i]
+    // и, если with_items, полный маршрут; nullopt, если остановка неизвестна или недостижима
+    std::vector<std::optional<domain::RouteResponse>> FindRoutes(
+        domain::StopId from, const std::vector<std::optional<domain::StopId>>& to, bool with_items) const;
+
+    // Время до всех остановок, достижимых из from не дольше max_time, включая саму from
+    std::vector<std::pair<domain::StopId, double>> FindReachableStops(domain::StopId from, double max_time) const;
+
+    size_t GetMemoryUsage() const;
+
+private:
+    // Направление движения автобуса: остановки по порядку и дорожное расстояние от первой
+    // из них. Время перегона считается как в рёбрах TransportRouter — разность расстояний,
+    // делённая на скорость, — чтобы суммы времён совпадали с графовыми движками до бита
+    struct Pattern {
+        const domain::Bus* bus = nullptr;
+        std::vector<size_t> stops;
+        std::vector<double> distances;
+    };
+
+    // Вхождение остановки в направление
+    struct PatternPosition {
+        size_t pattern;
+        size_t position;
+    };
+
+    // Как получено лучшее время прибытия на остановку: на каком направлении, где была
+    // посадка и высадка
+    struct Arrival {
+        size_t pattern;
+        size_t board_position;
+        size_t alight_position;
+    };
+
+    // Результат раундов от одной остановки. Время прибытия только уменьшается, поэтому
+    // для восстановления маршрута достаточно последнего улучшения каждой остановки
+    struct SearchResult {
+        std::vector<std::optional<Arrival>> parents;
+        std::vector<double> best_arrivals;
+    };
+
+    static constexpr size_t NO_STOP = static_cast<size_t>(-1);
+
+    // Если target равен NO_STOP, поиск не отсекается по времени прибытия в цель.
+    // Прибытия позже time_limit не рассматриваются
+    SearchResult Search(size_t source, size_t target, double time_limit) const;
+    domain::RouteResponse MakeResponse(const SearchResult& result, size_t source, size_t target) const;
+
+    void AddPattern(const domain::Bus* bus, std::vector<domain::StopId> stops);
+    double GetTravelTime(const Pattern& pattern, size_t from_position, size_t to_position) const;
+
+    const TransportCatalogue& catalogue_;
+    domain::RoutingSettings settings_;
+    // Скорость в метрах в минуту
+    double speed_ = 0.0;
+
+    size_t stop_count_ = 0;
+    std::vector<Pattern> patterns_;
+    std::vector<std::vector<PatternPosition>> stop_patterns_;
+};
+
+} // namespace transport
@@ -11,21 +11,49 @@ std::optional<domain::StopInfo> RequestHandler::GetStopInfo(std::string_view sto
     return db_.GetStopInfo(stop_name);
 }
 
+memory::MemoryReport RequestHandler::GetMemoryReport() const {
+    memory::MemoryReport report;
+    db_.ReportMemory(report);
+    return report;
+}
+
+std::vector<domain::NearbyStop> RequestHandler::GetStopsInRadius(geo::Coordinates center, double radius) const {
+    return db_.FindStopsInRadius(center, radius);
+}
+
+std::vector<domain::NearbyStop> RequestHandler::GetNearestStops(geo::Coordinates center, size_t count) const {
+    return db_.FindNearestStops(center, count);
+}
+
 svg::Document RequestHandler::RenderMap(const map_renderer::RenderSettings& settings) const {
     map_renderer::MapRenderer renderer;
     renderer.SetSettings(settings);
     return renderer.RenderMap(db_);
 }
 
-std::optional<domain::RouteResponse> RequestHandler::GetRoute(
+std::shared_ptr<const domain::RouteResponse> RequestHandler::GetRoute(
     std::string_view from, std::string_view to) const {
     
     auto router = db_.GetRouter();
     if (!router) {
-        return std::nullopt;
+        return nullptr;
     }
     
     return router->FindRoute(from, to);
 }
 
+std::optional<std::vector<domain::ReachableStop>> RequestHandler::GetReachableStops(
+    std::string_view from, double max_time) const {
+    
+    return db_.GetRouter()->FindReachableStops(from, max_time);
+}
+
+domain::RouteMatrix RequestHandler::GetRouteMatrix(
+    const std::vector<std::string_view>& from,
+    const std::vector<std::string_view>& to,
+    bool with_items) const {
+    
+    return db_.GetRouter()->BuildRouteMatrix(from, to, with_items);
+}
+
 } // namespace transport
\ No newline at end of file
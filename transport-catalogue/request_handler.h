@@ -14,11 +14,18 @@ public:
     // Методы для работы с транспортным каталогом
     std::optional<domain::BusInfo> GetBusInfo(std::string_view bus_name) const;
     std::optional<domain::StopInfo> GetStopInfo(std::string_view stop_name) const;
+    std::vector<domain::NearbyStop> GetStopsInRadius(geo::Coordinates center, double radius) const;
+    std::vector<domain::NearbyStop> GetNearestStops(geo::Coordinates center, size_t count) const;
+    memory::MemoryReport GetMemoryReport() const;
 
     svg::Document RenderMap() const;
     svg::Document RenderMap(const map_renderer::RenderSettings& settings) const;
 
-    std::optional<domain::RouteResponse> GetRoute(std::string_view from, std::string_view to) const;
+    std::shared_ptr<const domain::RouteResponse> GetRoute(std::string_view from, std::string_view to) const;
+    std::optional<std::vector<domain::ReachableStop>> GetReachableStops(std::string_view from, double max_time) const;
+    domain::RouteMatrix GetRouteMatrix(const std::vector<std::string_view>& from,
+                                       const std::vector<std::string_view>& to,
+                                       bool with_items) const;
 
 private:
     TransportCatalogue& db_;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "graph.h"
+#include "serialization.h"
 
 #include <algorithm>
 #include <cassert>
@@ -14,20 +15,50 @@
 
 namespace graph {
 
+// Общий интерфейс движков поиска маршрутов по графу
 template <typename Weight>
-class Router {
+class RouteEngine {
+public:
+    struct RouteInfo {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    virtual ~RouteEngine() = default;
+    virtual std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
+
+    // Сохраняет предподсчитанные данные. Движкам без предподсчёта сохранять нечего
+    virtual void Save(serialization::Writer& /*writer*/) const {
+    }
+
+    // Память предподсчёта в куче. Движки без предподсчёта держат только состояние
+    // поиска в потоках, оно не учитывается
+    virtual size_t GetMemoryUsage() const {
+        return 0;
+    }
+};
+
+// Предподсчёт всех пар вершин алгоритмом Флойда–Уоршелла: O(V^3) времени и O(V^2) памяти
+template <typename Weight>
+class Router : public RouteEngine<Weight> {
 private:
     using Graph = DirectedWeightedGraph<Weight>;
 
 public:
+    using typename RouteEngine<Weight>::RouteInfo;
+
     explicit Router(const Graph& graph);
+    // Восстанавливает таблицу, сохранённую методом Save, без пересчёта
+    Router(const Graph& graph, serialization::Reader& reader);
 
-    struct RouteInfo {
-        Weight weight;
-        std::vector<EdgeId> edges;
-    };
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
 
-    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Таблица пишется по строкам: признаки достижимости, веса и последние рёбра путей
+    void Save(serialization::Writer& writer) const override;
+
+    size_t GetMemoryUsage() const override {
+        return memory::GetHeapBytes(routes_internal_data_);
+    }
 
 private:
     struct RouteInternalData {
@@ -40,14 +71,13 @@ private:
         const size_t vertex_count = graph.GetVertexCount();
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
             routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
-            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-                const auto& edge = graph.GetEdge(edge_id);
+            for (const auto& edge : graph.GetIncidentEdges(vertex)) {
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
                 auto& route_internal_data = routes_internal_data_[vertex][edge.to];
                 if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                    route_internal_data = RouteInternalData{edge.weight, edge.id};
                 }
             }
         }
@@ -76,6 +106,7 @@ private:
     }
 
     static constexpr Weight ZERO_WEIGHT{};
+    static constexpr EdgeId NO_SAVED_EDGE = static_cast<EdgeId>(-1);
     const Graph& graph_;
     RoutesInternalData routes_internal_data_;
 };
@@ -94,6 +125,48 @@ Router<Weight>::Router(const Graph& graph)
     }
 }
 
+template <typename Weight>
+Router<Weight>::Router(const Graph& graph, serialization::Reader& reader)
+    : graph_(graph)
+    , routes_internal_data_(graph.GetVertexCount())
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    for (auto& row : routes_internal_data_) {
+        const auto reached = reader.ReadVector<uint8_t>();
+        const auto weights = reader.ReadVector<Weight>();
+        const auto prev_edges = reader.ReadVector<EdgeId>();
+        if (reached.size() != vertex_count || weights.size() != vertex_count || prev_edges.size() != vertex_count) {
+            throw std::runtime_error("Serialized all-pairs table does not match the graph");
+        }
+        row.resize(vertex_count);
+        for (VertexId to = 0; to < vertex_count; ++to) {
+            if (reached[to]) {
+                row[to] = RouteInternalData{weights[to], prev_edges[to] == NO_SAVED_EDGE
+                                                             ? std::nullopt
+                                                             : std::optional<EdgeId>(prev_edges[to])};
+            }
+        }
+    }
+}
+
+template <typename Weight>
+void Router<Weight>::Save(serialization::Writer& writer) const {
+    const size_t vertex_count = routes_internal_data_.size();
+    std::vector<uint8_t> reached(vertex_count);
+    std::vector<Weight> weights(vertex_count);
+    std::vector<EdgeId> prev_edges(vertex_count);
+    for (const auto& row : routes_internal_data_) {
+        for (VertexId to = 0; to < vertex_count; ++to) {
+            reached[to] = row[to].has_value();
+            weights[to] = row[to] ? row[to]->weight : ZERO_WEIGHT;
+            prev_edges[to] = row[to] && row[to]->prev_edge ? *row[to]->prev_edge : NO_SAVED_EDGE;
+        }
+        writer.WriteVector(reached);
+        writer.WriteVector(weights);
+        writer.WriteVector(prev_edges);
+    }
+}
+
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
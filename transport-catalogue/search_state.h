@@ -0,0 +1,65 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+inline constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+// Рабочие массивы одного направления поиска по графу: вес пути до вершины, ребро, по которому
+// она достигнута, и куча с ленивым удалением. Отметка stamp позволяет не очищать массивы
+// между запросами, поэтому движки держат по экземпляру на поток и переиспользуют его.
+template <typename Weight>
+struct SearchState {
+    using HeapItem = std::pair<Weight, VertexId>;
+
+    std::vector<Weight> weights;
+    std::vector<EdgeId> prev_edges;
+    std::vector<uint32_t> stamps;
+    std::vector<HeapItem> heap;
+    uint32_t stamp = 0;
+
+    void Prepare(size_t vertex_count) {
+        if (stamps.size() < vertex_count) {
+            weights.resize(vertex_count);
+            prev_edges.resize(vertex_count);
+            stamps.resize(vertex_count, 0);
+        }
+        heap.clear();
+        if (++stamp == 0) {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            stamp = 1;
+        }
+    }
+
+    bool IsReached(VertexId vertex) const {
+        return stamps[vertex] == stamp;
+    }
+
+    void Reach(VertexId vertex, Weight weight, EdgeId prev_edge) {
+        stamps[vertex] = stamp;
+        weights[vertex] = weight;
+        prev_edges[vertex] = prev_edge;
+    }
+
+    void Push(Weight key, VertexId vertex) {
+        heap.push_back({key, vertex});
+        std::push_heap(heap.begin(), heap.end(), std::greater<HeapItem>{});
+    }
+
+    HeapItem Pop() {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<HeapItem>{});
+        const HeapItem item = heap.back();
+        heap.pop_back();
+        return item;
+    }
+};
+
+}  // namespace graph
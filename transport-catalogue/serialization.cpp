@@ -0,0 +1,58 @@
+#include "serialization.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace serialization {
+
+using namespace std;
+
+uint64_t ComputeChecksum(const char* data, size_t size) {
+    constexpr uint64_t prime = 1099511628211ull;
+    uint64_t hash = 14695981039346656037ull ^ size;
+    size_t position = 0;
+    for (; position + sizeof(uint64_t) <= size; position += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data + position, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (; position < size; ++position) {
+        hash = (hash ^ static_cast<unsigned char>(data[position])) * prime;
+    }
+    return hash;
+}
+
+MappedFile::MappedFile(const string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("Cannot open file " + path);
+    }
+
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw runtime_error("Cannot stat file " + path);
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+
+    // Пустой файл отобразить нельзя, он читается как пустой блок
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw runtime_error("Cannot map file " + path);
+        }
+        data_ = static_cast<const char*>(data);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+} // namespace serialization
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace serialization {
+
+// Запись в двоичный поток: простые значения побайтно, векторы — длиной и содержимым
+class Writer {
+public:
+    explicit Writer(std::ostream& output)
+        : output_(output) {
+    }
+
+    template <typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be written");
+        output_.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    void WriteVector(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be written");
+        Write<uint64_t>(values.size());
+        output_.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    void WriteString(const std::string& value) {
+        Write<uint64_t>(value.size());
+        output_.write(value.data(), value.size());
+    }
+
+private:
+    std::ostream& output_;
+};
+
+// Чтение из непрерывного блока памяти, например из отображённого файла.
+// Векторы заполняются одним копированием, выход за границы блока — исключение
+class Reader {
+public:
+    Reader(const char* data, size_t size)
+        : data_(data)
+        , size_(size) {
+    }
+
+    template <typename T>
+    T Read() {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be read");
+        T value;
+        std::memcpy(&value, Take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    std::vector<T> ReadVector() {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be read");
+        const uint64_t count = Read<uint64_t>();
+        if (count > (size_ - position_) / sizeof(T)) {
+            throw std::runtime_error("Serialized data is truncated");
+        }
+        std::vector<T> values(count);
+        std::memcpy(values.data(), Take(count * sizeof(T)), count * sizeof(T));
+        return values;
+    }
+
+    std::string ReadString() {
+        const uint64_t size = Read<uint64_t>();
+        if (size > size_ - position_) {
+            throw std::runtime_error("Serialized data is truncated");
+        }
+        return std::string(Take(size), size);
+    }
+
+private:
+    const char* Take(size_t count) {
+        if (count > size_ - position_) {
+            throw std::runtime_error("Serialized data is truncated");
+        }
+        const char* result = data_ + position_;
+        position_ += count;
+        return result;
+    }
+
+    const char* data_;
+    size_t size_;
+    size_t position_ = 0;
+};
+
+// Контрольная сумма блока: FNV-1a по 8-байтовым словам, хвост — побайтно
+uint64_t ComputeChecksum(const char* data, size_t size);
+
+// Файл, отображённый в память только для чтения
+class MappedFile {
+public:
+    // Бросает std::runtime_error, если файл не удалось открыть или отобразить
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* GetData() const {
+        return data_;
+    }
+    size_t GetSize() const {
+        return size_;
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace serialization
@@ -0,0 +1,104 @@
+#define _USE_MATH_DEFINES
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace spatial {
+
+using namespace std;
+
+namespace {
+
+const double dr = M_PI / 180.;
+
+} // namespace
+
+void GridIndex::Rebuild(const vector<double>& latitudes, const vector<double>& longitudes) {
+    const size_t count = latitudes.size();
+    rows_ = 1;
+    columns_ = 1;
+    cell_size_ = 1.0;
+    if (count > 0) {
+        const auto [min_lat, max_lat] = minmax_element(latitudes.begin(), latitudes.end());
+        const auto [min_lng, max_lng] = minmax_element(longitudes.begin(), longitudes.end());
+        min_lat_ = *min_lat;
+        min_lng_ = *min_lng;
+        const double lat_span = *max_lat - *min_lat;
+        const double lng_span = *max_lng - *min_lng;
+
+        // Квадратные в градусах ячейки, не больше target по каждой стороне, даже если
+        // все точки лежат на одной линии
+        const double target = max<double>(1.0, count / 2.0);
+        cell_size_ = max(sqrt(lat_span * lng_span / target), max(lat_span, lng_span) / target);
+        if (cell_size_ > 0.0) {
+            rows_ = static_cast<size_t>(lat_span / cell_size_) + 1;
+            columns_ = static_cast<size_t>(lng_span / cell_size_) + 1;
+        } else {
+            cell_size_ = 1.0;
+        }
+    }
+
+    cells_.assign(rows_ * columns_, {});
+    for (size_t id = 0; id < count; ++id) {
+        Insert(static_cast<uint32_t>(id), {latitudes[id], longitudes[id]});
+    }
+}
+
+void GridIndex::Insert(uint32_t id, geo::Coordinates point) {
+    cells_[GetRow(point.lat) * columns_ + GetColumn(point.lng)].push_back(id);
+}
+
+size_t GridIndex::GetRow(double lat) const {
+    const double row = floor((lat - min_lat_) / cell_size_);
+    return static_cast<size_t>(clamp(row, 0.0, static_cast<double>(rows_ - 1)));
+}
+
+size_t GridIndex::GetColumn(double lng) const {
+    const double column = floor((lng - min_lng_) / cell_size_);
+    return static_cast<size_t>(clamp(column, 0.0, static_cast<double>(columns_ - 1)));
+}
+
+vector<GridIndex::CellRange> GridIndex::GetCellRanges(geo::Coordinates center, double radius) const {
+    if (radius < 0.0) {
+        return {};
+    }
+    // Угловой радиус круга. Небольшой запас покрывает погрешность вычислений
+    const double angle = radius / geo::kEarthRadius * (1.0 + 1e-9) + 1e-12;
+    const CellRange all_cells{0, rows_ - 1, 0, columns_ - 1};
+    if (angle >= M_PI) {
+        return {all_cells};
+    }
+
+    const double lat_delta = angle / dr;
+    const size_t first_row = GetRow(center.lat - lat_delta);
+    const size_t last_row = GetRow(center.lat + lat_delta);
+
+    // По формуле гаверсинусов hav(angle) >= cos(lat1) cos(lat2) hav(dlng), поэтому
+    // разность долгот ограничена через наибольшую по модулю широту круга
+    const double max_abs_lat = max(abs(center.lat - lat_delta), abs(center.lat + lat_delta));
+    const double sin_half_lng = max_abs_lat < 90.0 ? sin(angle / 2) / cos(max_abs_lat * dr) : 1.0;
+    if (sin_half_lng >= 1.0) {
+        return {{first_row, last_row, 0, columns_ - 1}};
+    }
+    const double lng_delta = 2 * asin(sin_half_lng) / dr;
+    const double first_lng = center.lng - lng_delta;
+    const double last_lng = center.lng + lng_delta;
+
+    vector<CellRange> ranges;
+    const auto add_range = [&](double from_lng, double to_lng) {
+        ranges.push_back({first_row, last_row, GetColumn(from_lng), GetColumn(to_lng)});
+    };
+    if (first_lng < -180.0) {
+        add_range(first_lng + 360.0, 180.0);
+        add_range(-180.0, last_lng);
+    } else if (last_lng > 180.0) {
+        add_range(first_lng, 180.0);
+        add_range(-180.0, last_lng - 360.0);
+    } else {
+        add_range(first_lng, last_lng);
+    }
+    return ranges;
+}
+
+} // namespace spatial
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "geo.h"
+#include "memory_report.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace spatial {
+
+// Равномерная сетка по широте и долготе над точками с плотными номерами. Отвечает
+// только на вопрос, какие точки могут лежать в круге: точное расстояние проверяет
+// вызывающий
+class GridIndex {
+public:
+    // Подбирает границы и размер ячеек под точки и раскладывает их заново.
+    // Ячеек примерно вдвое меньше, чем точек
+    void Rebuild(const std::vector<double>& latitudes, const std::vector<double>& longitudes);
+    // Добавляет точку без перестройки. Точка за границами сетки попадает в ближайшую
+    // крайнюю ячейку, поэтому поиск её не теряет
+    void Insert(uint32_t id, geo::Coordinates point);
+
+    // Вызывает visit(id) для точек всех ячеек, пересекающих область, в которую
+    // укладывается круг радиуса radius метров вокруг center
+    template <typename Visitor>
+    void ForEachCandidate(geo::Coordinates center, double radius, Visitor visit) const;
+
+    size_t GetMemoryUsage() const {
+        return memory::GetHeapBytes(cells_);
+    }
+
+private:
+    struct CellRange {
+        size_t first_row;
+        size_t last_row;
+        size_t first_column;
+        size_t last_column;
+    };
+
+    // Прямоугольники ячеек, покрывающие круг. Если круг пересекает 180-й меридиан,
+    // прямоугольников два
+    std::vector<CellRange> GetCellRanges(geo::Coordinates center, double radius) const;
+    size_t GetRow(double lat) const;
+    size_t GetColumn(double lng) const;
+
+    double min_lat_ = 0.0;
+    double min_lng_ = 0.0;
+    double cell_size_ = 1.0; // в градусах
+    size_t rows_ = 1;
+    size_t columns_ = 1;
+    // Ячейка (row, column) хранится под номером row * columns_ + column. До первой
+    // перестройки сетка состоит из одной ячейки
+    std::vector<std::vector<uint32_t>> cells_ = std::vector<std::vector<uint32_t>>(1);
+};
+
+template <typename Visitor>
+void GridIndex::ForEachCandidate(geo::Coordinates center, double radius, Visitor visit) const {
+    for (const CellRange& range : GetCellRanges(center, radius)) {
+        for (size_t row = range.first_row; row <= range.last_row; ++row) {
+            for (size_t column = range.first_column; column <= range.last_column; ++column) {
+                for (uint32_t id : cells_[row * columns_ + column]) {
+                    visit(id);
+                }
+            }
+        }
+    }
+}
+
+} // namespace spatial
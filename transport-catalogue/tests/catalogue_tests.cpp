@@ -0,0 +1,315 @@
+#include "tests.h"
+#include "test_framework.h"
+#include "test_network.h"
+
+#include "../lru_cache.h"
+#include "../transport_catalogue.h"
+#include "../transport_router.h"
+#include "../versioned_catalogue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <set>
+#include <thread>
+
+namespace tests {
+
+using namespace std;
+using namespace transport;
+
+namespace {
+
+vector<string> GetBusNames(const TransportCatalogue& catalogue, ranges::Range<const domain::BusId*> buses) {
+    vector<string> names;
+    for (domain::BusId bus : buses) {
+        names.push_back(catalogue.GetBus(bus)->name);
+    }
+    return names;
+}
+
+// Названия автобусов и используемых остановок, посчитанные заново по индексу названий
+void CheckNameOrders(const TransportCatalogue& catalogue) {
+    vector<string> expected_buses;
+    set<pair<string_view, domain::StopId>> expected_stops;
+    for (const auto& [name, bus] : catalogue.GetAllBuses()) {
+        expected_buses.emplace_back(name);
+        for (domain::StopId stop : bus->stops) {
+            expected_stops.emplace(catalogue.GetStopName(stop), stop);
+        }
+    }
+    sort(expected_buses.begin(), expected_buses.end());
+    ASSERT(GetBusNames(catalogue, catalogue.GetAllBusesSorted()) == expected_buses);
+
+    vector<pair<string_view, domain::StopId>> stops;
+    for (domain::StopId stop : catalogue.GetStopsUsedInRoutes()) {
+        stops.emplace_back(catalogue.GetStopName(stop), stop);
+    }
+    const vector<pair<string_view, domain::StopId>> expected_stop_list(expected_stops.begin(), expected_stops.end());
+    ASSERT(stops == expected_stop_list);
+
+    // У каждой остановки автобусы без повторов, по названию, и только действующие
+    for (domain::StopId stop = 0; stop < static_cast<domain::StopId>(catalogue.GetStopsCount()); ++stop) {
+        const vector<string> buses = GetBusNames(catalogue, catalogue.GetStopInfo(catalogue.GetStopName(stop))->buses);
+        ASSERT(is_sorted(buses.begin(), buses.end()));
+        ASSERT(adjacent_find(buses.begin(), buses.end()) == buses.end());
+        for (const string& bus : buses) {
+            const auto& stops = catalogue.GetBus(bus)->stops;
+            ASSERT(find(stops.begin(), stops.end(), stop) != stops.end());
+        }
+    }
+}
+
+} // namespace
+
+void TestLruCache() {
+    cache::LruCache<int, string> lru(2, 1);
+    ASSERT(!lru.Find(1));
+    lru.Insert(1, "one"s);
+    lru.Insert(2, "two"s);
+    ASSERT_EQUAL(*lru.Find(1), "one"s);
+    // 2 использовался давнее 1, поэтому вытесняется
+    lru.Insert(3, "three"s);
+    ASSERT(!lru.Find(2));
+    ASSERT_EQUAL(*lru.Find(1), "one"s);
+    ASSERT_EQUAL(*lru.Find(3), "three"s);
+    lru.Insert(1, "uno"s);
+    ASSERT_EQUAL(*lru.Find(1), "uno"s);
+    const cache::CacheStats stats = lru.GetStats();
+    ASSERT_EQUAL(stats.hits, 4u);
+    ASSERT_EQUAL(stats.misses, 2u);
+    lru.Clear();
+    ASSERT(!lru.Find(1));
+
+    cache::LruCache<int, int> disabled(0);
+    disabled.Insert(1, 1);
+    ASSERT(!disabled.Find(1));
+
+    // Сегменты делят ёмкость, поэтому свежие записи не вытесняются раньше времени
+    cache::LruCache<int, int> sharded(1600, 16);
+    for (int key = 0; key < 1600; ++key) {
+        sharded.Insert(key, key);
+    }
+    int retained = 0;
+    for (int key = 1400; key < 1600; ++key) {
+        retained += sharded.Find(key).has_value();
+    }
+    ASSERT_EQUAL(retained, 200);
+}
+
+void TestNameOrdersFollowEdits() {
+    TransportCatalogue catalogue;
+    FillRandomNetwork(catalogue, 11);
+    CheckNameOrders(catalogue);
+
+    mt19937 generator(11);
+    for (int step = 0; step < 500; ++step) {
+        const string bus = "Edited "s + to_string(generator() % 30);
+        if (generator() % 3 == 0) {
+            catalogue.RemoveBus(bus);
+        } else {
+            vector<string> stops;
+            for (size_t i = generator() % 5 + 2; i > 0; --i) {
+                stops.push_back(GetStopName(generator() % catalogue.GetStopsCount()));
+            }
+            catalogue.AddBus(bus, vector<string_view>(stops.begin(), stops.end()), generator() % 2 == 0);
+        }
+        if (step % 25 == 0) {
+            CheckNameOrders(catalogue);
+        }
+    }
+    CheckNameOrders(catalogue);
+}
+
+void TestReaddedBusReplacesOld() {
+    TransportCatalogue catalogue;
+    catalogue.AddStop("A"sv, {55.60, 37.60});
+    catalogue.AddStop("B"sv, {55.61, 37.60});
+    catalogue.AddStop("C"sv, {55.62, 37.60});
+    catalogue.AddBus("1"sv, {"A"sv, "B"sv}, false);
+    catalogue.PrecomputeBusInfo();
+    catalogue.AddBus("1"sv, {"B"sv, "C"sv, "B"sv}, true);
+
+    ASSERT_EQUAL(catalogue.GetAllBuses().size(), 1u);
+    ASSERT(GetBusNames(catalogue, catalogue.GetAllBusesSorted()) == vector<string>{"1"s});
+    ASSERT(GetBusNames(catalogue, catalogue.GetStopInfo("A"sv)->buses).empty());
+    ASSERT(GetBusNames(catalogue, catalogue.GetStopInfo("B"sv)->buses) == vector<string>{"1"s});
+    ASSERT(GetBusNames(catalogue, catalogue.GetStopInfo("C"sv)->buses) == vector<string>{"1"s});
+    const auto info = catalogue.GetBusInfo("1"sv);
+    ASSERT(info);
+    ASSERT_EQUAL(info->stops_count, 3u);
+    ASSERT_EQUAL(info->unique_stops_count, 2u);
+    CheckNameOrders(catalogue);
+}
+
+void TestBusInfo() {
+    TransportCatalogue catalogue;
+    FillRandomNetwork(catalogue, 12);
+    // Посчитанное на лету и из таблицы должно совпадать с длинами по перегонам
+    for (bool precomputed : {false, true}) {
+        if (precomputed) {
+            catalogue.PrecomputeBusInfo();
+        }
+        for (const auto& [name, bus] : catalogue.GetAllBuses()) {
+            double road_length = 0.0;
+            double geo_length = 0.0;
+            for (size_t i = 1; i < bus->stops.size(); ++i) {
+                const domain::StopId from = bus->stops[i - 1];
+                const domain::StopId to = bus->stops[i];
+                const double geo_distance = geo::ComputeDistance(catalogue.GetStopCoordinates(from),
+                                                                 catalogue.GetStopCoordinates(to));
+                road_length += catalogue.GetDistance(from, to);
+                geo_length += geo_distance;
+                if (!bus->is_roundtrip) {
+                    road_length += catalogue.GetDistance(to, from);
+                    geo_length += geo_distance;
+                }
+            }
+            const auto info = catalogue.GetBusInfo(name);
+            ASSERT(info);
+            ASSERT_EQUAL(info->stops_count, bus->is_roundtrip ? bus->stops.size() : bus->stops.size() * 2 - 1);
+            ASSERT_NEAR(info->route_length, road_length);
+            ASSERT_NEAR(info->curvature, road_length / geo_length);
+        }
+    }
+}
+
+void TestStopsInRadius() {
+    TransportCatalogue catalogue;
+    FillRandomNetwork(catalogue, 13, {300, 10, 5});
+    const auto check = [&catalogue]() {
+        mt19937 generator(13);
+        uniform_real_distribution<double> latitude(55.5, 55.9);
+        uniform_real_distribution<double> longitude(37.35, 37.85);
+        for (int i = 0; i < 50; ++i) {
+            const geo::Coordinates center{latitude(generator), longitude(generator)};
+            vector<pair<double, domain::StopId>> all;
+            for (domain::StopId stop = 0; stop < static_cast<domain::StopId>(catalogue.GetStopsCount()); ++stop) {
+                all.emplace_back(geo::ComputeDistance(center, catalogue.GetStopCoordinates(stop)), stop);
+            }
+            sort(all.begin(), all.end());
+
+            for (double radius : {0.0, 500.0, 2000.0, 8000.0}) {
+                const auto found = catalogue.FindStopsInRadius(center, radius);
+                size_t expected_count = 0;
+                while (expected_count < all.size() && all[expected_count].first <= radius) {
+                    ++expected_count;
+                }
+                ASSERT_EQUAL(found.size(), expected_count);
+                for (size_t j = 0; j < found.size(); ++j) {
+                    ASSERT_EQUAL(found[j].stop, all[j].second);
+                    ASSERT_NEAR(found[j].distance, all[j].first);
+                }
+            }
+            for (size_t count : {size_t{0}, size_t{1}, size_t{7}, all.size() + 5}) {
+                const auto nearest = catalogue.FindNearestStops(center, count);
+                ASSERT_EQUAL(nearest.size(), min(count, all.size()));
+                for (size_t j = 0; j < nearest.size(); ++j) {
+                    ASSERT_EQUAL(nearest[j].stop, all[j].second);
+                }
+            }
+        }
+    };
+    check();
+    // Остановки, добавленные после заморозки, попадают в сетку сразу
+    catalogue.Freeze();
+    catalogue.AddStop("Late stop"sv, {55.7, 37.6});
+    check();
+}
+
+void TestMemoryReport() {
+    TransportCatalogue catalogue;
+    FillRandomNetwork(catalogue, 14);
+    memory::MemoryReport before;
+    catalogue.ReportMemory(before);
+
+    catalogue.SetRoutingSettings(MakeRoutingSettings(domain::RouterType::CONTRACTION_HIERARCHIES));
+    catalogue.GetRouter()->FindRoute(GetStopName(0), GetStopName(1));
+    memory::MemoryReport after;
+    catalogue.ReportMemory(after);
+
+    size_t total = 0;
+    set<string> names;
+    for (const memory::MemoryReport::Item& item : after.GetItems()) {
+        total += item.bytes;
+        ASSERT_HINT(names.insert(item.name).second, item.name);
+    }
+    ASSERT_EQUAL(total, after.GetTotal());
+    ASSERT(names.count("stops"s) && names.count("buses"s) && names.count("stop_distances"s));
+    ASSERT(names.count("router.graph"s) && names.count("router.engine"s));
+    ASSERT(after.GetTotal() > before.GetTotal());
+    for (const memory::MemoryReport::Item& item : before.GetItems()) {
+        ASSERT_HINT(item.name.rfind("router."s, 0) != 0, item.name);
+    }
+}
+
+void TestSnapshots() {
+    auto initial = make_unique<TransportCatalogue>();
+    FillRandomNetwork(*initial, 15);
+    const domain::RoutingSettings settings = MakeRoutingSettings(domain::RouterType::DIJKSTRA);
+    initial->SetRoutingSettings(settings);
+    initial->GetRouter();
+    VersionedCatalogue versions(move(initial));
+    ASSERT_EQUAL(versions.GetVersion(), 0u);
+
+    auto old_snapshot = versions.Acquire();
+    const auto old_route = old_snapshot->GetRouter()->FindRoute(GetStopName(0), "New stop"sv);
+    ASSERT(!old_route);
+
+    const uint64_t version = versions.Apply([](TransportCatalogue& catalogue) {
+        catalogue.AddStop("New stop"sv, {55.7, 37.6});
+        catalogue.AddBus("New bus"sv, {GetStopName(0), "New stop"sv}, false);
+    });
+    ASSERT_EQUAL(version, 1u);
+    ASSERT_EQUAL(versions.GetVersion(), 1u);
+
+    // Закреплённая версия не меняется, новая видит изменения и роутер перенесён в неё
+    ASSERT(!old_snapshot->GetBus("New bus"sv));
+    ASSERT(!old_snapshot->GetStop("New stop"sv));
+    {
+        const auto snapshot = versions.Acquire();
+        ASSERT(snapshot->GetBus("New bus"sv));
+        const auto reference = ComputeReferenceTimes(*snapshot, settings);
+        const auto new_stop = snapshot->GetStop("New stop"sv)->id;
+        const auto route = snapshot->GetRouter()->FindRoute(GetStopName(0), "New stop"sv);
+        CheckRoute(route.get(), reference[0][new_stop], settings, "new version"s);
+    }
+    old_snapshot = versions.Acquire();
+    versions.Reclaim();
+    ASSERT(old_snapshot->GetBus("New bus"sv));
+
+    // Читатели работают одновременно с писателем и всегда видят целую версию
+    atomic<bool> done{false};
+    atomic<int> broken{0};
+    vector<thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&versions, &done, &broken]() {
+            while (!done.load()) {
+                const auto snapshot = versions.Acquire();
+                const bool has_bus = snapshot->GetBus("Counter"sv) != nullptr;
+                const bool has_stop = snapshot->GetStop("Counter stop"sv).has_value();
+                if (has_bus && !has_stop) {
+                    ++broken;
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 20; ++i) {
+        versions.Apply([i](TransportCatalogue& catalogue) {
+            if (i % 2 == 0) {
+                catalogue.AddStop("Counter stop"sv, {55.75, 37.65});
+                catalogue.AddBus("Counter"sv, {GetStopName(0), "Counter stop"sv}, false);
+            } else {
+                catalogue.RemoveBus("Counter"sv);
+            }
+        });
+    }
+    done = true;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQUAL(broken.load(), 0);
+    ASSERT_EQUAL(versions.GetVersion(), 21u);
+}
+
+} // namespace tests
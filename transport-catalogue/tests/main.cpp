@@ -0,0 +1,28 @@
+#include "tests.h"
+#include "test_framework.h"
+
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++17 -O2 -pthread tests/*.cpp $(ls *.cpp | grep -v main.cpp) -o transport_catalogue_tests
+int main() {
+    using namespace tests;
+
+    RUN_TEST(TestDijkstraMatchesReference);
+    RUN_TEST(TestAStarMatchesReference);
+    RUN_TEST(TestContractionHierarchiesMatchReference);
+    RUN_TEST(TestAllPairsMatchesReference);
+    RUN_TEST(TestBlockedAllPairsMatchesReference);
+    RUN_TEST(TestRaptorMatchesReference);
+    RUN_TEST(TestRouteMatrixMatchesReference);
+    RUN_TEST(TestReachableStopsMatchReference);
+    RUN_TEST(TestIncrementalUpdatesMatchReference);
+    RUN_TEST(TestRouterFileRoundTrip);
+    RUN_TEST(TestCorruptRouterFileIsRebuilt);
+
+    RUN_TEST(TestLruCache);
+    RUN_TEST(TestNameOrdersFollowEdits);
+    RUN_TEST(TestReaddedBusReplacesOld);
+    RUN_TEST(TestBusInfo);
+    RUN_TEST(TestStopsInRadius);
+    RUN_TEST(TestMemoryReport);
+    RUN_TEST(TestSnapshots);
+}
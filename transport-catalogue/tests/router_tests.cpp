@@ -0,0 +1,284 @@
+#include "tests.h"
+#include "test_framework.h"
+#include "test_network.h"
+
+#include "../transport_catalogue.h"
+#include "../transport_router.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+namespace tests {
+
+using namespace std;
+using namespace transport;
+
+namespace {
+
+const vector<domain::RouterType> ALL_ROUTER_TYPES = {
+    domain::RouterType::DIJKSTRA,
+    domain::RouterType::ASTAR,
+    domain::RouterType::CONTRACTION_HIERARCHIES,
+    domain::RouterType::ALL_PAIRS,
+    domain::RouterType::ALL_PAIRS_BLOCKED,
+    domain::RouterType::RAPTOR,
+};
+
+string MakeHint(const string& context, size_t from, size_t to) {
+    return context + ": "s + GetStopName(from) + " -> "s + GetStopName(to);
+}
+
+// Сравнивает ответы роутера на все пары остановок с эталоном по текущему состоянию каталога
+void CheckAllRoutes(const TransportCatalogue& catalogue, const TransportRouter& router,
+                    const domain::RoutingSettings& settings, const string& context) {
+    const auto reference = ComputeReferenceTimes(catalogue, settings);
+    const size_t stop_count = catalogue.GetStopsCount();
+    for (size_t from = 0; from < stop_count; ++from) {
+        for (size_t to = 0; to < stop_count; ++to) {
+            const auto route = router.FindRoute(catalogue.GetStopName(from), catalogue.GetStopName(to));
+            CheckRoute(route.get(), reference[from][to], settings, MakeHint(context, from, to));
+        }
+    }
+}
+
+void CheckEngineMatchesReference(domain::RouterType router_type) {
+    for (uint32_t seed : {1u, 2u, 3u}) {
+        for (bool frozen : {false, true}) {
+            TransportCatalogue catalogue;
+            FillRandomNetwork(catalogue, seed);
+            if (frozen) {
+                catalogue.Freeze();
+            }
+            const domain::RoutingSettings settings = MakeRoutingSettings(router_type);
+            catalogue.SetRoutingSettings(settings);
+            const auto router = catalogue.GetRouter();
+            const string context = "seed "s + to_string(seed) + (frozen ? " frozen"s : ""s);
+            CheckAllRoutes(catalogue, *router, settings, context);
+            // Повторные запросы отвечаются из кэша и должны совпадать с первыми
+            CheckAllRoutes(catalogue, *router, settings, context + " cached"s);
+        }
+    }
+}
+
+string GetRouterFilePath(domain::RouterType router_type) {
+    return (filesystem::temp_directory_path()
+            / ("transport_router_test_"s + to_string(static_cast<int>(router_type)) + ".bin"s)).string();
+}
+
+string ReadFile(const string& path) {
+    ifstream input(path, ios::binary);
+    return {istreambuf_iterator<char>(input), istreambuf_iterator<char>()};
+}
+
+void WriteFile(const string& path, const string& content) {
+    ofstream output(path, ios::binary | ios::trunc);
+    output << content;
+}
+
+} // namespace
+
+void TestDijkstraMatchesReference() {
+    CheckEngineMatchesReference(domain::RouterType::DIJKSTRA);
+}
+
+void TestAStarMatchesReference() {
+    CheckEngineMatchesReference(domain::RouterType::ASTAR);
+}
+
+void TestContractionHierarchiesMatchReference() {
+    CheckEngineMatchesReference(domain::RouterType::CONTRACTION_HIERARCHIES);
+}
+
+void TestAllPairsMatchesReference() {
+    CheckEngineMatchesReference(domain::RouterType::ALL_PAIRS);
+}
+
+void TestBlockedAllPairsMatchesReference() {
+    CheckEngineMatchesReference(domain::RouterType::ALL_PAIRS_BLOCKED);
+}
+
+void TestRaptorMatchesReference() {
+    CheckEngineMatchesReference(domain::RouterType::RAPTOR);
+}
+
+void TestRouteMatrixMatchesReference() {
+    for (domain::RouterType router_type : {domain::RouterType::DIJKSTRA, domain::RouterType::RAPTOR}) {
+        TransportCatalogue catalogue;
+        FillRandomNetwork(catalogue, 4);
+        const domain::RoutingSettings settings = MakeRoutingSettings(router_type);
+        catalogue.SetRoutingSettings(settings);
+        const auto reference = ComputeReferenceTimes(catalogue, settings);
+
+        vector<string> names;
+        for (size_t stop = 0; stop < static_cast<size_t>(catalogue.GetStopsCount()); ++stop) {
+            names.push_back(GetStopName(stop));
+        }
+        const vector<string_view> stops(names.begin(), names.end());
+        const domain::RouteMatrix matrix = catalogue.GetRouter()->BuildRouteMatrix(stops, stops, true);
+        ASSERT_EQUAL(matrix.total_times.size(), stops.size());
+        ASSERT_EQUAL(matrix.routes.size(), stops.size());
+        for (size_t from = 0; from < stops.size(); ++from) {
+            for (size_t to = 0; to < stops.size(); ++to) {
+                const string hint = MakeHint("matrix"s, from, to);
+                const auto& total_time = matrix.total_times[from][to];
+                const auto& route = matrix.routes[from][to];
+                ASSERT_EQUAL_HINT(total_time.has_value(), route.has_value(), hint);
+                CheckRoute(route ? &*route : nullptr, reference[from][to], settings, hint);
+                if (total_time) {
+                    ASSERT_NEAR_HINT(*total_time, reference[from][to], hint);
+                }
+            }
+        }
+    }
+}
+
+void TestReachableStopsMatchReference() {
+    for (domain::RouterType router_type : {domain::RouterType::DIJKSTRA, domain::RouterType::RAPTOR}) {
+        TransportCatalogue catalogue;
+        FillRandomNetwork(catalogue, 5);
+        const domain::RoutingSettings settings = MakeRoutingSettings(router_type);
+        catalogue.SetRoutingSettings(settings);
+        const auto router = catalogue.GetRouter();
+        const auto reference = ComputeReferenceTimes(catalogue, settings);
+
+        ASSERT(!router->FindReachableStops("Unknown stop"sv, 10.0));
+        for (double max_time : {0.0, 15.0, 40.0, 1000.0}) {
+            for (size_t from = 0; from < static_cast<size_t>(catalogue.GetStopsCount()); ++from) {
+                const auto reachable = router->FindReachableStops(GetStopName(from), max_time);
+                ASSERT(reachable);
+                map<string, double> expected;
+                for (size_t to = 0; to < reference[from].size(); ++to) {
+                    if (reference[from][to] <= max_time) {
+                        expected[GetStopName(to)] = reference[from][to];
+                    }
+                }
+                ASSERT_EQUAL(reachable->size(), expected.size());
+                for (size_t i = 0; i < reachable->size(); ++i) {
+                    const domain::ReachableStop& stop = (*reachable)[i];
+                    ASSERT(expected.count(stop.stop_name));
+                    ASSERT_NEAR(stop.time, expected.at(stop.stop_name));
+                    if (i > 0) {
+                        ASSERT((*reachable)[i - 1].time <= stop.time);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void TestIncrementalUpdatesMatchReference() {
+    for (domain::RouterType router_type : ALL_ROUTER_TYPES) {
+        TransportCatalogue catalogue;
+        FillRandomNetwork(catalogue, 6);
+        const domain::RoutingSettings settings = MakeRoutingSettings(router_type);
+        catalogue.SetRoutingSettings(settings);
+        const auto router = catalogue.GetRouter();
+        CheckAllRoutes(catalogue, *router, settings, "initial"s);
+
+        // Каждое изменение правит построенный роутер, а не заменяет его новым
+        catalogue.AddStop("New stop"sv, {55.7, 37.6});
+        catalogue.AddDistance("New stop"sv, GetStopName(0), 1500);
+        catalogue.AddBus("New bus"sv, {GetStopName(0), "New stop"sv, GetStopName(1)}, false);
+        ASSERT(catalogue.GetRouter() == router);
+        CheckAllRoutes(catalogue, *router, settings, "added bus"s);
+
+        // Автобус с существующим названием заменяет прежний
+        catalogue.AddBus(GetBusName(0), {GetStopName(2), GetStopName(3), GetStopName(2)}, true);
+        ASSERT(catalogue.GetRouter() == router);
+        CheckAllRoutes(catalogue, *router, settings, "replaced bus"s);
+
+        catalogue.RemoveBus(GetBusName(1));
+        ASSERT(catalogue.GetRouter() == router);
+        CheckAllRoutes(catalogue, *router, settings, "removed bus"s);
+
+        const domain::Bus* bus = catalogue.GetBus(GetBusName(2));
+        catalogue.AddDistance(catalogue.GetStopName(bus->stops[0]), catalogue.GetStopName(bus->stops[1]), 7);
+        ASSERT(catalogue.GetRouter() == router);
+        CheckAllRoutes(catalogue, *router, settings, "changed distance"s);
+    }
+}
+
+void TestRouterFileRoundTrip() {
+    for (domain::RouterType router_type : ALL_ROUTER_TYPES) {
+        TransportCatalogue catalogue;
+        FillRandomNetwork(catalogue, 7);
+        const domain::RoutingSettings settings = MakeRoutingSettings(router_type);
+        const string path = GetRouterFilePath(router_type);
+
+        TransportRouter built(catalogue, settings);
+        built.BuildGraph();
+        built.SaveToFile(path);
+
+        TransportRouter loaded(catalogue, settings);
+        ASSERT(loaded.LoadFromFile(path));
+        CheckAllRoutes(catalogue, loaded, settings, "loaded"s);
+
+        // Файл с другими настройками или по другому каталогу не подходит
+        domain::RoutingSettings other_settings = settings;
+        other_settings.bus_velocity += 1.0;
+        TransportRouter other_router(catalogue, other_settings);
+        ASSERT(!other_router.LoadFromFile(path));
+
+        const domain::Bus* bus = catalogue.GetBus(GetBusName(0));
+        catalogue.AddDistance(catalogue.GetStopName(bus->stops[0]), catalogue.GetStopName(bus->stops[1]), 12345);
+        TransportRouter changed(catalogue, settings);
+        ASSERT(!changed.LoadFromFile(path));
+        filesystem::remove(path);
+    }
+}
+
+void TestCorruptRouterFileIsRebuilt() {
+    for (domain::RouterType router_type : ALL_ROUTER_TYPES) {
+        TransportCatalogue catalogue;
+        FillRandomNetwork(catalogue, 8);
+        const domain::RoutingSettings settings = MakeRoutingSettings(router_type);
+        const string path = GetRouterFilePath(router_type);
+
+        TransportRouter built(catalogue, settings);
+        built.BuildGraph();
+        built.SaveToFile(path);
+        const string content = ReadFile(path);
+        ASSERT(!content.empty());
+
+        string flipped = content;
+        flipped[flipped.size() / 2] ^= 0x5a;
+        string wrong_magic = content;
+        wrong_magic[0] ^= 0x01;
+        const vector<string> corrupted = {
+            ""s,
+            "not a router file"s,
+            content.substr(0, content.size() / 2),
+            content.substr(0, content.size() - 1),
+            flipped,
+            wrong_magic,
+        };
+        for (const string& bad_content : corrupted) {
+            WriteFile(path, bad_content);
+            TransportRouter router(catalogue, settings);
+            ASSERT(!router.LoadFromFile(path));
+        }
+        filesystem::remove(path);
+        TransportRouter missing(catalogue, settings);
+        ASSERT(!missing.LoadFromFile(path));
+
+        // Каталог строит роутер заново и перезаписывает испорченный файл
+        WriteFile(path, flipped);
+        catalogue.SetRoutingSettings(settings);
+        catalogue.SetSerializationSettings({path});
+        CheckAllRoutes(catalogue, *catalogue.GetRouter(), settings, "rebuilt"s);
+        TransportRouter reloaded(catalogue, settings);
+        ASSERT(reloaded.LoadFromFile(path));
+        filesystem::remove(path);
+
+        // Незаписываемый файл тоже не мешает работе
+        TransportCatalogue unwritable;
+        FillRandomNetwork(unwritable, 8);
+        unwritable.SetRoutingSettings(settings);
+        unwritable.SetSerializationSettings({"/nonexistent-directory/router.bin"s});
+        CheckAllRoutes(unwritable, *unwritable.GetRouter(), settings, "unwritable"s);
+    }
+}
+
+} // namespace tests
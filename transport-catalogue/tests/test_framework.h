@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace tests {
+
+// Проверки в стиле assert, которые работают и в сборке с NDEBUG. При провале печатают
+// место и выражение и завершают программу
+inline void AssertImpl(bool value, const std::string& expr, const std::string& file, const std::string& func,
+                       unsigned line, const std::string& hint) {
+    if (!value) {
+        std::cerr << file << "(" << line << "): " << func << ": ASSERT(" << expr << ") failed.";
+        if (!hint.empty()) {
+            std::cerr << " Hint: " << hint;
+        }
+        std::cerr << std::endl;
+        std::abort();
+    }
+}
+
+template <typename T, typename U>
+void AssertEqualImpl(const T& t, const U& u, const std::string& t_str, const std::string& u_str,
+                     const std::string& file, const std::string& func, unsigned line, const std::string& hint) {
+    if (t != u) {
+        std::cerr << file << "(" << line << "): " << func << ": ASSERT_EQUAL(" << t_str << ", " << u_str
+                  << ") failed: " << t << " != " << u << ".";
+        if (!hint.empty()) {
+            std::cerr << " Hint: " << hint;
+        }
+        std::cerr << std::endl;
+        std::abort();
+    }
+}
+
+// Времена маршрутов складываются из дробных весов в разном порядке, поэтому сравниваются
+// с относительной погрешностью
+inline void AssertNearImpl(double t, double u, const std::string& t_str, const std::string& u_str,
+                           const std::string& file, const std::string& func, unsigned line, const std::string& hint) {
+    if (std::abs(t - u) > 1e-9 * std::max({1.0, std::abs(t), std::abs(u)})) {
+        std::cerr.precision(17);
+        std::cerr << file << "(" << line << "): " << func << ": ASSERT_NEAR(" << t_str << ", " << u_str
+                  << ") failed: " << t << " != " << u << ".";
+        if (!hint.empty()) {
+            std::cerr << " Hint: " << hint;
+        }
+        std::cerr << std::endl;
+        std::abort();
+    }
+}
+
+template <typename Func>
+void RunTestImpl(Func func, const std::string& func_name) {
+    func();
+    std::cerr << func_name << " OK" << std::endl;
+}
+
+} // namespace tests
+
+#define ASSERT(expr) tests::AssertImpl(!!(expr), #expr, __FILE__, __FUNCTION__, __LINE__, "")
+#define ASSERT_HINT(expr, hint) tests::AssertImpl(!!(expr), #expr, __FILE__, __FUNCTION__, __LINE__, (hint))
+#define ASSERT_EQUAL(a, b) tests::AssertEqualImpl((a), (b), #a, #b, __FILE__, __FUNCTION__, __LINE__, "")
+#define ASSERT_EQUAL_HINT(a, b, hint) \
+    tests::AssertEqualImpl((a), (b), #a, #b, __FILE__, __FUNCTION__, __LINE__, (hint))
+#define ASSERT_NEAR(a, b) tests::AssertNearImpl((a), (b), #a, #b, __FILE__, __FUNCTION__, __LINE__, "")
+#define ASSERT_NEAR_HINT(a, b, hint) tests::AssertNearImpl((a), (b), #a, #b, __FILE__, __FUNCTION__, __LINE__, (hint))
+#define RUN_TEST(func) tests::RunTestImpl((func), #func)
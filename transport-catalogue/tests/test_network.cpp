@@ -0,0 +1,145 @@
+#include "test_network.h"
+#include "test_framework.h"
+
+#include <algorithm>
+#include <random>
+
+namespace tests {
+
+using namespace std;
+
+string GetStopName(size_t index) {
+    return "Stop "s + to_string(index);
+}
+
+string GetBusName(size_t index) {
+    return "Bus "s + to_string(index);
+}
+
+void FillRandomNetwork(transport::TransportCatalogue& catalogue, uint32_t seed, const NetworkSize& size) {
+    mt19937 generator(seed);
+    uniform_real_distribution<double> latitude(55.55, 55.85);
+    uniform_real_distribution<double> longitude(37.40, 37.80);
+    uniform_real_distribution<double> road_ratio(0.9, 1.6);
+
+    vector<geo::Coordinates> coordinates;
+    for (size_t i = 0; i < size.stop_count; ++i) {
+        coordinates.push_back({latitude(generator), longitude(generator)});
+        catalogue.AddStop(GetStopName(i), coordinates.back());
+    }
+
+    // Маршруты проходят только по первым трём четвертям остановок
+    const size_t used_stop_count = max<size_t>(2, size.stop_count * 3 / 4);
+    uniform_int_distribution<size_t> stop_index(0, used_stop_count - 1);
+    uniform_int_distribution<size_t> bus_length(2, max<size_t>(2, size.max_bus_stops));
+    for (size_t i = 0; i < size.bus_count; ++i) {
+        vector<string> stops;
+        const size_t length = bus_length(generator);
+        while (stops.size() < length) {
+            const string stop = GetStopName(stop_index(generator));
+            if (stops.empty() || stops.back() != stop) {
+                stops.push_back(stop);
+            }
+        }
+        const bool is_roundtrip = generator() % 2 == 0;
+        if (is_roundtrip) {
+            stops.push_back(stops.front());
+        }
+
+        // Дорожные расстояния задаются у половины перегонов, иногда только в одну сторону.
+        // Остальные перегоны считаются по прямой
+        for (size_t j = 1; j < stops.size(); ++j) {
+            if (generator() % 2 != 0) {
+                continue;
+            }
+            const auto from = catalogue.GetStop(stops[j - 1]);
+            const auto to = catalogue.GetStop(stops[j]);
+            const double geo_distance = geo::ComputeDistance(from->coordinates, to->coordinates);
+            const int distance = max(1, static_cast<int>(geo_distance * road_ratio(generator)));
+            catalogue.AddDistance(stops[j - 1], stops[j], distance);
+            if (generator() % 3 == 0) {
+                catalogue.AddDistance(stops[j], stops[j - 1], distance + 100);
+            }
+        }
+
+        const vector<string_view> stop_views(stops.begin(), stops.end());
+        catalogue.AddBus(GetBusName(i), stop_views, is_roundtrip);
+    }
+}
+
+domain::RoutingSettings MakeRoutingSettings(domain::RouterType router_type) {
+    domain::RoutingSettings settings;
+    settings.bus_wait_time = 6;
+    settings.bus_velocity = 40.0;
+    settings.router_type = router_type;
+    return settings;
+}
+
+vector<vector<double>> ComputeReferenceTimes(const transport::TransportCatalogue& catalogue,
+                                             const domain::RoutingSettings& settings) {
+    const size_t stop_count = catalogue.GetStopsCount();
+    vector<vector<double>> times(stop_count, vector<double>(stop_count, NO_ROUTE));
+    for (size_t stop = 0; stop < stop_count; ++stop) {
+        times[stop][stop] = 0.0;
+    }
+
+    const double speed_m_per_min = settings.bus_velocity * 1000.0 / 60.0;
+    const auto relax = [&times](domain::StopId from, domain::StopId to, double time) {
+        times[from][to] = min(times[from][to], time);
+    };
+    for (const auto& [name, bus] : catalogue.GetAllBuses()) {
+        const auto& stops = bus->stops;
+        for (size_t i = 0; i < stops.size(); ++i) {
+            double forward = 0.0;
+            for (size_t j = i + 1; j < stops.size(); ++j) {
+                forward += catalogue.GetDistanceBetween(stops[j - 1], stops[j]);
+                relax(stops[i], stops[j], settings.bus_wait_time + forward / speed_m_per_min);
+            }
+            if (!bus->is_roundtrip) {
+                double backward = 0.0;
+                for (size_t j = i; j > 0; --j) {
+                    backward += catalogue.GetDistanceBetween(stops[j], stops[j - 1]);
+                    relax(stops[i], stops[j - 1], settings.bus_wait_time + backward / speed_m_per_min);
+                }
+            }
+        }
+    }
+
+    for (size_t via = 0; via < stop_count; ++via) {
+        for (size_t from = 0; from < stop_count; ++from) {
+            if (times[from][via] == NO_ROUTE) {
+                continue;
+            }
+            for (size_t to = 0; to < stop_count; ++to) {
+                times[from][to] = min(times[from][to], times[from][via] + times[via][to]);
+            }
+        }
+    }
+    return times;
+}
+
+void CheckRoute(const domain::RouteResponse* route, double reference, const domain::RoutingSettings& settings,
+                const string& hint) {
+    ASSERT_EQUAL_HINT(route != nullptr, reference != NO_ROUTE, hint);
+    if (!route) {
+        return;
+    }
+    ASSERT_NEAR_HINT(route->total_time, reference, hint);
+
+    double items_time = 0.0;
+    for (size_t i = 0; i < route->items.size(); ++i) {
+        const domain::RouteItem& item = route->items[i];
+        items_time += item.time;
+        if (i % 2 == 0) {
+            ASSERT_EQUAL_HINT(item.type, "Wait"s, hint);
+            ASSERT_NEAR_HINT(item.time, static_cast<double>(settings.bus_wait_time), hint);
+        } else {
+            ASSERT_EQUAL_HINT(item.type, "Bus"s, hint);
+            ASSERT_HINT(item.span_count > 0, hint);
+        }
+    }
+    ASSERT_EQUAL_HINT(route->items.size() % 2, 0u, hint);
+    ASSERT_NEAR_HINT(items_time, route->total_time, hint);
+}
+
+} // namespace tests
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../domain.h"
+#include "../transport_catalogue.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tests {
+
+// Размеры случайной сети. Часть остановок не входит ни в один маршрут, поэтому между
+// некоторыми парами маршрута нет
+struct NetworkSize {
+    size_t stop_count = 40;
+    size_t bus_count = 12;
+    size_t max_bus_stops = 7;
+};
+
+// Заполняет пустой каталог случайной сетью: остановки «Stop <номер>», автобусы
+// «Bus <номер>», кольцевые и линейные, дорожные расстояния заданы у части перегонов.
+// Один seed — одна и та же сеть
+void FillRandomNetwork(transport::TransportCatalogue& catalogue, uint32_t seed, const NetworkSize& size = {});
+
+std::string GetStopName(size_t index);
+std::string GetBusName(size_t index);
+
+domain::RoutingSettings MakeRoutingSettings(domain::RouterType router_type);
+
+inline constexpr double NO_ROUTE = std::numeric_limits<double>::infinity();
+
+// Эталонные времена между всеми парами остановок: Флойд–Уоршелл по остановкам, где ребро —
+// поездка от любой остановки маршрута до любой следующей с одним ожиданием. Считается
+// прямо по каталогу, без графа TransportRouter. NO_ROUTE, если маршрута нет
+std::vector<std::vector<double>> ComputeReferenceTimes(const transport::TransportCatalogue& catalogue,
+                                                       const domain::RoutingSettings& settings);
+
+// Проверяет ответ роутера по эталону: наличие маршрута, общее время, сумму времён
+// элементов и чередование ожиданий и поездок
+void CheckRoute(const domain::RouteResponse* route, double reference, const domain::RoutingSettings& settings,
+                const std::string& hint);
+
+} // namespace tests
@@ -0,0 +1,26 @@
+#pragma once
+
+namespace tests {
+
+// Маршруты каждого движка сравниваются с эталоном, посчитанным по каталогу без графа
+void TestDijkstraMatchesReference();
+void TestAStarMatchesReference();
+void TestContractionHierarchiesMatchReference();
+void TestAllPairsMatchesReference();
+void TestBlockedAllPairsMatchesReference();
+void TestRaptorMatchesReference();
+void TestRouteMatrixMatchesReference();
+void TestReachableStopsMatchReference();
+void TestIncrementalUpdatesMatchReference();
+void TestRouterFileRoundTrip();
+void TestCorruptRouterFileIsRebuilt();
+
+void TestLruCache();
+void TestNameOrdersFollowEdits();
+void TestReaddedBusReplacesOld();
+void TestBusInfo();
+void TestStopsInRadius();
+void TestMemoryReport();
+void TestSnapshots();
+
+} // namespace tests
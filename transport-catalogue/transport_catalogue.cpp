@@ -1,40 +1,145 @@
+#define _USE_MATH_DEFINES
 #include <algorithm>
 #include <cmath>
 #include <unordered_set>
 #include <stdexcept>
 
 #include "transport_catalogue.h"
+#include "parallel.h"
 #include "transport_router.h" 
 
 namespace transport {
 
 using namespace std;
 
-size_t TransportCatalogue::PairStopHasher::operator()(const std::pair<const domain::Stop*, const domain::Stop*>& stops) const { 
-    return std::hash<const void*>{}(stops.first) * 37 +  
-        std::hash<const void*>{}(stops.second);
-} 
+TransportCatalogue::TransportCatalogue(const TransportCatalogue& other)
+    : stop_latitudes_(other.stop_latitudes_)
+    , stop_longitudes_(other.stop_longitudes_)
+    , stop_geo_terms_(other.stop_geo_terms_)
+    , stop_grid_(other.stop_grid_)
+    , stop_names_(other.stop_names_)
+    , stop_name_offsets_(other.stop_name_offsets_)
+    , stop_name_index_(other.stop_name_index_)
+    , buses_(other.buses_.begin(), other.buses_.end(), memory::CountingAllocator<domain::Bus>(&buses_bytes_))
+    , stop_to_buses_(other.stop_to_buses_)
+    , sorted_buses_(other.sorted_buses_)
+    , sorted_used_stops_(other.sorted_used_stops_)
+    , bus_infos_(other.bus_infos_)
+    , bus_infos_ready_(other.bus_infos_ready_)
+    , stops_distances_(other.stops_distances_, DistanceMap::allocator_type(&distances_bytes_))
+    , distance_offsets_(other.distance_offsets_)
+    , road_distances_(other.road_distances_)
+    , routing_settings_(other.routing_settings_) {
+    // Индекс названий указывает на автобусы копии. Удалённые автобусы остаются в deque,
+    // поэтому индекс переносится по записям оригинала, а не строится по всем автобусам
+    bus_name_to_bus_.reserve(other.bus_name_to_bus_.size());
+    for (const auto& [name, bus] : other.bus_name_to_bus_) {
+        const domain::Bus& copy = buses_[bus->id];
+        bus_name_to_bus_[copy.name] = &copy;
+    }
+
+    if (const auto router = other.WaitRouter()) {
+        promise<shared_ptr<TransportRouter>> copied;
+        copied.set_value(make_shared<TransportRouter>(*router, *this));
+        router_future_ = copied.get_future().share();
+    }
+}
+
+void TransportCatalogue::AddStop(string_view name, geo::Coordinates coords) {
+    // Фоновое построение роутера читает каталог, менять его можно только после окончания
+    const auto router = WaitRouter();
+    const domain::StopId id = InsertStop(name, coords);
+    if (router) {
+        router->AddStop(id);
+    }
+}
 
-void TransportCatalogue::AddStop(const std::string& name, geo::Coordinates coords) {
-    // Важно: используем deque для сохранения указателей при добавлении новых элементов
-    stops_.push_back({name, coords});
-    const domain::Stop* new_stop = &stops_.back();
-    stop_name_to_stop_[new_stop->name] = new_stop;
+domain::StopId TransportCatalogue::InsertStop(string_view name, geo::Coordinates coords) {
+    const domain::StopId id = static_cast<domain::StopId>(stop_latitudes_.size());
+    stop_latitudes_.push_back(coords.lat);
+    stop_longitudes_.push_back(coords.lng);
+    stop_geo_terms_.push_back(geo::ComputePointTerms(coords));
+    stop_grid_.Insert(id, coords);
+    stop_names_ += name;
+    stop_name_offsets_.push_back(static_cast<uint32_t>(stop_names_.size()));
+    IndexStopName(id);
     
     // Инициализируем пустой набор автобусов для новой остановки
-    stop_to_buses_[new_stop];
+    stop_to_buses_.emplace_back();
+    if (IsFrozen()) {
+        distance_offsets_.push_back(distance_offsets_.back());
+    }
+    return id;
+}
+
+void TransportCatalogue::IndexStopName(domain::StopId id) {
+    // Таблица заполняется не больше чем наполовину, чтобы цепочки проб оставались короткими
+    if ((static_cast<size_t>(id) + 1) * 2 > stop_name_index_.size()) {
+        ResizeStopNameIndex(max<size_t>(16, stop_name_index_.size() * 2), id);
+    }
+    const size_t mask = stop_name_index_.size() - 1;
+    size_t slot = hash<string_view>{}(GetStopName(id)) & mask;
+    while (stop_name_index_[slot] != NO_STOP) {
+        slot = (slot + 1) & mask;
+    }
+    stop_name_index_[slot] = id;
 }
 
-void TransportCatalogue::AddBus(const std::string& name, const std::vector<std::string>& stop_names, bool is_roundtrip) {
+void TransportCatalogue::ResizeStopNameIndex(size_t size, domain::StopId indexed_count) {
+    vector<domain::StopId> index(size, NO_STOP);
+    stop_name_index_.swap(index);
+    for (domain::StopId indexed = 0; indexed < indexed_count; ++indexed) {
+        IndexStopName(indexed);
+    }
+}
+
+optional<domain::StopId> TransportCatalogue::FindStopId(string_view name) const {
+    if (stop_name_index_.empty()) {
+        return nullopt;
+    }
+    const size_t mask = stop_name_index_.size() - 1;
+    for (size_t slot = hash<string_view>{}(name) & mask; stop_name_index_[slot] != NO_STOP; slot = (slot + 1) & mask) {
+        if (GetStopName(stop_name_index_[slot]) == name) {
+            return stop_name_index_[slot];
+        }
+    }
+    return nullopt;
+}
+
+void TransportCatalogue::AddBus(string_view name, const vector<string_view>& stop_names, bool is_roundtrip) {
+    const auto router = WaitRouter();
+    const domain::Bus* replaced = GetBus(name);
+    const optional<domain::BusId> replaced_id = replaced ? optional(replaced->id) : nullopt;
+    const domain::BusId id = InsertBus(name, ranges::AsSpan(stop_names), is_roundtrip);
+    InsertIntoNameOrders(id);
+    RefreshBusInfo({id});
+    if (router) {
+        if (replaced_id) {
+            router->RemoveBus(*replaced_id);
+        }
+        router->AddBus(id);
+    }
+}
+
+domain::BusId TransportCatalogue::InsertBus(string_view name, ranges::Range<const string_view*> stop_names,
+                                            bool is_roundtrip) {
+    // Автобус с тем же названием заменяет прежний: прежний убирается так же, как в RemoveBus,
+    // иначе его номер остался бы в списках остановок и упорядоченных массивах
+    if (auto it = bus_name_to_bus_.find(name); it != bus_name_to_bus_.end()) {
+        domain::Bus& replaced = buses_[it->second->id];
+        bus_name_to_bus_.erase(it);
+        DetachBus(replaced);
+    }
+
     domain::Bus bus;
     bus.name = name;
     bus.is_roundtrip = is_roundtrip;
+    bus.id = static_cast<domain::BusId>(buses_.size());
 
     // Находим все остановки по именам
-    for (const auto& stop_name : stop_names) {
-        auto it = stop_name_to_stop_.find(stop_name);
-        if (it != stop_name_to_stop_.end()) {
-            bus.stops.push_back(it->second);
+    for (string_view stop_name : stop_names) {
+        if (const auto stop_id = FindStopId(stop_name)) {
+            bus.stops.push_back(*stop_id);
         }
     }
     
@@ -46,105 +151,427 @@ void TransportCatalogue::AddBus(const std::string& name, const std::vector<std::
     bus_name_to_bus_[new_bus->name] = new_bus;
     
     // Добавляем автобус во все его остановки
-    for (const domain::Stop* stop : new_bus->stops) {
-        stop_to_buses_[stop].insert(new_bus->name);
+    for (domain::StopId stop : new_bus->stops) {
+        auto& stop_buses = stop_to_buses_[stop];
+        const auto position = lower_bound(stop_buses.begin(), stop_buses.end(), new_bus->name,
+            [this](domain::BusId bus, const string& name) {
+                return buses_[bus].name < name;
+            });
+        // Автобус может проходить через остановку несколько раз
+        if (position == stop_buses.end() || *position != new_bus->id) {
+            stop_buses.insert(position, new_bus->id);
+        }
+    }
+    return new_bus->id;
+}
+
+void TransportCatalogue::Reserve(const Capacity& capacity) {
+    const size_t stop_count = stop_latitudes_.size() + capacity.stop_count;
+    stop_latitudes_.reserve(stop_count);
+    stop_longitudes_.reserve(stop_count);
+    stop_geo_terms_.reserve(stop_count);
+    stop_name_offsets_.reserve(stop_count + 1);
+    stop_to_buses_.reserve(stop_count);
+    stop_names_.reserve(stop_names_.size() + capacity.stop_names_size);
+    size_t index_size = max<size_t>(16, stop_name_index_.size());
+    while (index_size < stop_count * 2) {
+        index_size *= 2;
+    }
+    if (index_size > stop_name_index_.size()) {
+        ResizeStopNameIndex(index_size, static_cast<domain::StopId>(stop_latitudes_.size()));
+    }
+
+    stops_distances_.reserve(stops_distances_.size() + capacity.distance_count);
+    bus_name_to_bus_.reserve(bus_name_to_bus_.size() + capacity.bus_count);
+}
+
+void TransportCatalogue::AddStops(ranges::Range<const StopInput*> stops) {
+    const auto router = WaitRouter();
+    for (const StopInput& stop : stops) {
+        InsertStop(stop.name, stop.coordinates);
     }
+    DropRouter(router);
 }
 
-void TransportCatalogue::AddDistance(const std::string& from, const std::string& to, int distance) {
-    const domain::Stop* stop_from = GetStop(from);
-    const domain::Stop* stop_to = GetStop(to);
+void TransportCatalogue::AddDistances(ranges::Range<const DistanceInput*> distances) {
+    const auto router = WaitRouter();
+    // Замороженные расстояния распаковываются и упаковываются один раз на весь пакет
+    const bool frozen = IsFrozen();
+    if (frozen) {
+        Thaw();
+    }
+    for (const DistanceInput& distance : distances) {
+        const auto stop_from = FindStopId(distance.from);
+        const auto stop_to = FindStopId(distance.to);
+        if (stop_from && stop_to) {
+            stops_distances_[MakeDistanceKey(*stop_from, *stop_to)] = distance.distance;
+        }
+    }
+    if (frozen) {
+        Freeze();
+    }
+    if (bus_infos_ready_) {
+        PrecomputeBusInfo();
+    }
+    DropRouter(router);
+}
+
+void TransportCatalogue::AddBuses(ranges::Range<const BusInput*> buses) {
+    const auto router = WaitRouter();
+    vector<domain::BusId> ids;
+    for (const BusInput& bus : buses) {
+        ids.push_back(InsertBus(bus.name, bus.stops, bus.is_roundtrip));
+    }
+    RebuildNameOrders();
+    RefreshBusInfo(ids);
+    DropRouter(router);
+}
+
+void TransportCatalogue::DropRouter(const shared_ptr<TransportRouter>& router) {
+    // Пакет меняет каталог сильно, поэтому роутер не правится точечно, а строится
+    // заново при следующем обращении
+    if (router) {
+        lock_guard guard(router_mutex_);
+        router_future_ = {};
+    }
+}
+
+void TransportCatalogue::RebuildNameOrders() {
+    sorted_buses_.clear();
+    sorted_buses_.reserve(bus_name_to_bus_.size());
+    for (const auto& [name, bus] : bus_name_to_bus_) {
+        sorted_buses_.push_back(bus->id);
+    }
+    sort(sorted_buses_.begin(), sorted_buses_.end(), [this](domain::BusId lhs, domain::BusId rhs) {
+        return buses_[lhs].name < buses_[rhs].name;
+    });
+
+    sorted_used_stops_.clear();
+    for (domain::StopId stop = 0; stop < stop_to_buses_.size(); ++stop) {
+        if (!stop_to_buses_[stop].empty()) {
+            sorted_used_stops_.push_back(stop);
+        }
+    }
+    sort(sorted_used_stops_.begin(), sorted_used_stops_.end(), [this](domain::StopId lhs, domain::StopId rhs) {
+        return StopNameLess(lhs, rhs);
+    });
+}
+
+void TransportCatalogue::InsertIntoNameOrders(domain::BusId bus) {
+    const domain::Bus& new_bus = buses_[bus];
+    const auto bus_position = lower_bound(sorted_buses_.begin(), sorted_buses_.end(), new_bus.name,
+        [this](domain::BusId id, const string& name) {
+            return buses_[id].name < name;
+        });
+    sorted_buses_.insert(bus_position, bus);
+
+    const auto stop_less = [this](domain::StopId lhs, domain::StopId rhs) {
+        return StopNameLess(lhs, rhs);
+    };
+    for (domain::StopId stop : new_bus.stops) {
+        // Через остановку с другими автобусами она уже есть в массиве
+        if (stop_to_buses_[stop].size() != 1) {
+            continue;
+        }
+        const auto position = lower_bound(sorted_used_stops_.begin(), sorted_used_stops_.end(), stop, stop_less);
+        if (position == sorted_used_stops_.end() || *position != stop) {
+            sorted_used_stops_.insert(position, stop);
+        }
+    }
+}
+
+void TransportCatalogue::EraseFromNameOrders(const domain::Bus& bus) {
+    const auto bus_position = lower_bound(sorted_buses_.begin(), sorted_buses_.end(), bus.name,
+        [this](domain::BusId id, const string& name) {
+            return buses_[id].name < name;
+        });
+    if (bus_position != sorted_buses_.end() && *bus_position == bus.id) {
+        sorted_buses_.erase(bus_position);
+    }
+
+    const auto stop_less = [this](domain::StopId lhs, domain::StopId rhs) {
+        return StopNameLess(lhs, rhs);
+    };
+    for (domain::StopId stop : bus.stops) {
+        if (!stop_to_buses_[stop].empty()) {
+            continue;
+        }
+        const auto position = lower_bound(sorted_used_stops_.begin(), sorted_used_stops_.end(), stop, stop_less);
+        if (position != sorted_used_stops_.end() && *position == stop) {
+            sorted_used_stops_.erase(position);
+        }
+    }
+}
+
+bool TransportCatalogue::StopNameLess(domain::StopId lhs, domain::StopId rhs) const {
+    const string_view lhs_name = GetStopName(lhs);
+    const string_view rhs_name = GetStopName(rhs);
+    return lhs_name != rhs_name ? lhs_name < rhs_name : lhs < rhs;
+}
+
+void TransportCatalogue::RemoveBus(string_view name) {
+    auto it = bus_name_to_bus_.find(name);
+    if (it == bus_name_to_bus_.end()) {
+        return;
+    }
+    const auto router = WaitRouter();
+    domain::Bus& bus = buses_[it->second->id];
+    bus_name_to_bus_.erase(it);
+    DetachBus(bus);
+    if (router) {
+        router->RemoveBus(bus.id);
+    }
+}
+
+void TransportCatalogue::DetachBus(domain::Bus& bus) {
+    for (domain::StopId stop : bus.stops) {
+        auto& stop_buses = stop_to_buses_[stop];
+        stop_buses.erase(remove(stop_buses.begin(), stop_buses.end(), bus.id), stop_buses.end());
+    }
+    EraseFromNameOrders(bus);
+    bus.stops.clear();
+    RefreshBusInfo({bus.id});
+}
+
+void TransportCatalogue::AddDistance(string_view from, string_view to, int distance) {
+    const auto stop_from = FindStopId(from);
+    const auto stop_to = FindStopId(to);
     if (stop_from && stop_to) {
-        stops_distances_[{stop_from, stop_to}] = distance;
+        const auto router = WaitRouter();
+        if (RoadDistance* road_distance = IsFrozen() ? FindRoadDistance(*stop_from, *stop_to) : nullptr) {
+            // Перегон уже упакован: меняем его на месте вместе с копией в обратной строке
+            road_distance->distance = distance;
+            road_distance->reverse = false;
+            RoadDistance* reverse_distance = FindRoadDistance(*stop_to, *stop_from);
+            if (reverse_distance && reverse_distance->reverse) {
+                reverse_distance->distance = distance;
+            }
+        } else if (IsFrozen()) {
+            Thaw();
+            stops_distances_[MakeDistanceKey(*stop_from, *stop_to)] = distance;
+            Freeze();
+        } else {
+            stops_distances_[MakeDistanceKey(*stop_from, *stop_to)] = distance;
+        }
+
+        // Расстояние используется и в обратную сторону, если оно не задано отдельно,
+        // поэтому пересчитываются все автобусы, проходящие через обе остановки
+        if (router || bus_infos_ready_) {
+            const auto& to_buses = stop_to_buses_[*stop_to];
+            vector<domain::BusId> buses;
+            for (domain::BusId bus : stop_to_buses_[*stop_from]) {
+                if (find(to_buses.begin(), to_buses.end(), bus) != to_buses.end()) {
+                    buses.push_back(bus);
+                }
+            }
+            RefreshBusInfo(buses);
+            if (router) {
+                router->UpdateBuses(buses);
+            }
+        }
     }
 }
 
+void TransportCatalogue::Freeze() {
+    if (IsFrozen()) {
+        return;
+    }
+    stop_grid_.Rebuild(stop_latitudes_, stop_longitudes_);
+
+    const auto stop_count = static_cast<domain::StopId>(GetStopsCount());
+    vector<pair<domain::StopId, RoadDistance>> entries;
+    entries.reserve(stops_distances_.size() * 2);
+    for (const auto& [key, distance] : stops_distances_) {
+        const auto from = static_cast<domain::StopId>(key >> 32);
+        const auto to = static_cast<domain::StopId>(key);
+        entries.push_back({from, {to, distance, false}});
+        if (!stops_distances_.count(MakeDistanceKey(to, from))) {
+            entries.push_back({to, {from, distance, true}});
+        }
+    }
+    sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first != rhs.first ? lhs.first < rhs.first : lhs.second.to < rhs.second.to;
+    });
+
+    distance_offsets_.assign(stop_count + 1, 0);
+    road_distances_.clear();
+    road_distances_.reserve(entries.size());
+    for (const auto& [from, road_distance] : entries) {
+        ++distance_offsets_[from + 1];
+        road_distances_.push_back(road_distance);
+    }
+    for (domain::StopId stop = 0; stop < stop_count; ++stop) {
+        distance_offsets_[stop + 1] += distance_offsets_[stop];
+    }
+    stops_distances_ = DistanceMap(stops_distances_.get_allocator());
+}
+
+bool TransportCatalogue::IsFrozen() const {
+    return !distance_offsets_.empty();
+}
+
+void TransportCatalogue::Thaw() {
+    const auto stop_count = static_cast<domain::StopId>(GetStopsCount());
+    for (domain::StopId from = 0; from < stop_count; ++from) {
+        for (uint32_t i = distance_offsets_[from]; i < distance_offsets_[from + 1]; ++i) {
+            if (!road_distances_[i].reverse) {
+                stops_distances_[MakeDistanceKey(from, road_distances_[i].to)] = road_distances_[i].distance;
+            }
+        }
+    }
+    vector<uint32_t>{}.swap(distance_offsets_);
+    vector<RoadDistance>{}.swap(road_distances_);
+}
+
+TransportCatalogue::RoadDistance* TransportCatalogue::FindRoadDistance(domain::StopId from, domain::StopId to) {
+    return const_cast<RoadDistance*>(static_cast<const TransportCatalogue&>(*this).FindRoadDistance(from, to));
+}
+
+const TransportCatalogue::RoadDistance* TransportCatalogue::FindRoadDistance(domain::StopId from, domain::StopId to) const {
+    // Строки короткие (соседи остановки по маршрутам), поэтому линейный проход
+    // по упорядоченной строке обычно укладывается в одну-две кэш-линии
+    const RoadDistance* end = road_distances_.data() + distance_offsets_[from + 1];
+    for (const RoadDistance* it = road_distances_.data() + distance_offsets_[from]; it != end && it->to <= to; ++it) {
+        if (it->to == to) {
+            return it;
+        }
+    }
+    return nullptr;
+}
+
 const domain::Bus* TransportCatalogue::GetBus(string_view name) const {
     auto it = bus_name_to_bus_.find(name);
     return it != bus_name_to_bus_.end() ? it->second : nullptr;
 }
 
-const domain::Stop* TransportCatalogue::GetStop(string_view name) const {
-    auto it = stop_name_to_stop_.find(name);
-    return it != stop_name_to_stop_.end() ? it->second : nullptr;
+optional<domain::Stop> TransportCatalogue::GetStop(string_view name) const {
+    if (const auto id = FindStopId(name)) {
+        return GetStop(*id);
+    }
+    return nullopt;
+}
+
+domain::Stop TransportCatalogue::GetStop(domain::StopId id) const {
+    return {GetStopName(id), GetStopCoordinates(id), id};
+}
+
+const domain::Bus* TransportCatalogue::GetBus(domain::BusId id) const {
+    return &buses_.at(id);
+}
+
+string_view TransportCatalogue::GetStopName(domain::StopId id) const {
+    const uint32_t begin = stop_name_offsets_.at(id);
+    return string_view(stop_names_).substr(begin, stop_name_offsets_[id + 1] - begin);
+}
+
+geo::Coordinates TransportCatalogue::GetStopCoordinates(domain::StopId id) const {
+    return {stop_latitudes_.at(id), stop_longitudes_[id]};
+}
+
+const geo::PointTerms& TransportCatalogue::GetStopGeoTerms(domain::StopId id) const {
+    return stop_geo_terms_.at(id);
+}
+
+const vector<double>& TransportCatalogue::GetStopLatitudes() const {
+    return stop_latitudes_;
+}
+
+const vector<double>& TransportCatalogue::GetStopLongitudes() const {
+    return stop_longitudes_;
 }
 
-int TransportCatalogue::GetDistance(const domain::Stop* from, const domain::Stop* to) const {
+optional<int> TransportCatalogue::FindDistance(domain::StopId from, domain::StopId to) const {
+    if (IsFrozen()) {
+        // Строка from содержит и прямое, и обратное расстояние, прямое в приоритете
+        if (const RoadDistance* road_distance = FindRoadDistance(from, to)) {
+            return road_distance->distance;
+        }
+        return nullopt;
+    }
     // Сначала ищем прямое расстояние
-    auto it = stops_distances_.find({from, to});
+    auto it = stops_distances_.find(MakeDistanceKey(from, to));
     if (it != stops_distances_.end()) {
         return it->second;
     }
     // Если не найдено, ищем обратное расстояние
-    it = stops_distances_.find({to, from});
+    it = stops_distances_.find(MakeDistanceKey(to, from));
     if (it != stops_distances_.end()) {
         return it->second;
     }
+    return nullopt;
+}
+
+int TransportCatalogue::GetDistance(domain::StopId from, domain::StopId to) const {
+    if (const auto distance = FindDistance(from, to)) {
+        return *distance;
+    }
     // Если расстояние не задано, вычисляем географическое
-    double geo_dist = geo::ComputeDistance(from->coordinates, to->coordinates);
+    double geo_dist = geo::ComputeDistance(GetStopGeoTerms(from), GetStopGeoTerms(to));
     int result = static_cast<int>(geo_dist);
     return result;
 }
 
+void TransportCatalogue::PrecomputeBusInfo() {
+    bus_infos_.assign(buses_.size(), nullopt);
+    // Строки таблицы независимы, каждый поток пишет только в свои
+    parallel::ForEachIndex(buses_.size(), [this](size_t bus) {
+        if (!buses_[bus].stops.empty()) {
+            bus_infos_[bus] = ComputeBusInfo(buses_[bus]);
+        }
+    });
+    bus_infos_ready_ = true;
+}
+
+void TransportCatalogue::RefreshBusInfo(const vector<domain::BusId>& buses) {
+    if (!bus_infos_ready_) {
+        return;
+    }
+    bus_infos_.resize(buses_.size());
+    for (domain::BusId bus : buses) {
+        bus_infos_[bus] = buses_[bus].stops.empty() ? nullopt : optional(ComputeBusInfo(buses_[bus]));
+    }
+}
+
 optional<domain::BusInfo> TransportCatalogue::GetBusInfo(string_view bus_name) const {
     const domain::Bus* bus = GetBus(bus_name);
     if (!bus || bus->stops.empty()) {
         return nullopt;
     }
+    if (bus_infos_ready_) {
+        return bus_infos_[bus->id];
+    }
+    return ComputeBusInfo(*bus);
+}
 
+domain::BusInfo TransportCatalogue::ComputeBusInfo(const domain::Bus& bus) const {
     domain::BusInfo info;
 
     // Вычисляем количество остановок
-    if (bus->is_roundtrip) {
-        info.stops_count = bus->stops.size();
+    if (bus.is_roundtrip) {
+        info.stops_count = bus.stops.size();
     } else {
-        info.stops_count = bus->stops.size() * 2 - 1;
+        info.stops_count = bus.stops.size() * 2 - 1;
     }
 
     // Вычисляем количество уникальных остановок
-    unordered_set<const domain::Stop*> unique_stops(bus->stops.begin(), bus->stops.end());
+    unordered_set<domain::StopId> unique_stops(bus.stops.begin(), bus.stops.end());
     info.unique_stops_count = unique_stops.size();
 
-    // Вычисляем длины маршрутов
+    // Вычисляем длины маршрутов. Тригонометрия остановок посчитана заранее в
+    // stop_geo_terms_, поэтому перегон стоит одного cos и одного acos. Географическая
+    // длина перегона служит и запасным дорожным расстоянием, в обратную сторону она та же
     double road_length = 0.0;
     double geo_length = 0.0;
-
-    if (bus->is_roundtrip) {
-        // Кольцевой маршрут
-        for (size_t i = 1; i < bus->stops.size(); ++i) {
-            const domain::Stop* from = bus->stops[i - 1];
-            const domain::Stop* to = bus->stops[i];
-            
-            int dist = GetDistance(from, to);
-            double geo_dist = geo::ComputeDistance(from->coordinates, to->coordinates);
-            
-            road_length += dist;
-            geo_length += geo_dist;
-        }
-    } else {
-        // Прямой путь
-        for (size_t i = 1; i < bus->stops.size(); ++i) {
-            const domain::Stop* from = bus->stops[i - 1];
-            const domain::Stop* to = bus->stops[i];
-            
-            int dist = GetDistance(from, to);
-            double geo_dist = geo::ComputeDistance(from->coordinates, to->coordinates);
-            
-            road_length += dist;
-            geo_length += geo_dist;
-            
-        }
-
-        for (size_t i = bus->stops.size() - 1; i > 0; --i) {
-            const domain::Stop* from = bus->stops[i];
-            const domain::Stop* to = bus->stops[i - 1];
-            
-            int dist = GetDistance(from, to);
-            double geo_dist = geo::ComputeDistance(from->coordinates, to->coordinates);
-            
-            road_length += dist;
-            geo_length += geo_dist;
-            
+    for (size_t i = 1; i < bus.stops.size(); ++i) {
+        const domain::StopId from = bus.stops[i - 1];
+        const domain::StopId to = bus.stops[i];
+        const double geo_distance = geo::ComputeDistance(stop_geo_terms_[from], stop_geo_terms_[to]);
+        const int fallback = static_cast<int>(geo_distance);
+        road_length += FindDistance(from, to).value_or(fallback);
+        geo_length += geo_distance;
+        if (!bus.is_roundtrip) {
+            road_length += FindDistance(to, from).value_or(fallback);
+            geo_length += geo_distance;
         }
     }
 
@@ -159,96 +586,169 @@ optional<domain::BusInfo> TransportCatalogue::GetBusInfo(string_view bus_name) c
     return info;
 }
 
+vector<domain::NearbyStop> TransportCatalogue::FindStopsInRadius(geo::Coordinates center, double radius) const {
+    const geo::PointTerms center_terms = geo::ComputePointTerms(center);
+    vector<domain::NearbyStop> result;
+    stop_grid_.ForEachCandidate(center, radius, [&](domain::StopId stop) {
+        const double distance = geo::ComputeDistance(center_terms, stop_geo_terms_[stop]);
+        if (distance <= radius) {
+            result.push_back({stop, distance});
+        }
+    });
+    sort(result.begin(), result.end(), [](const domain::NearbyStop& lhs, const domain::NearbyStop& rhs) {
+        return lhs.distance != rhs.distance ? lhs.distance < rhs.distance : lhs.stop < rhs.stop;
+    });
+    return result;
+}
+
+vector<domain::NearbyStop> TransportCatalogue::FindNearestStops(geo::Coordinates center, size_t count) const {
+    if (count == 0) {
+        return {};
+    }
+    // Радиус растёт, пока в круг не попадёт count остановок: ближайшие count остановок
+    // лежат в любом круге, где их не меньше count. Круг радиуса pi * R покрывает всю Землю
+    const double max_radius = M_PI * geo::kEarthRadius;
+    for (double radius = 100.0;; radius *= 4) {
+        auto result = FindStopsInRadius(center, min(radius, max_radius));
+        if (result.size() >= count || radius >= max_radius) {
+            result.resize(min(result.size(), count));
+            return result;
+        }
+    }
+}
+
 optional<domain::StopInfo> TransportCatalogue::GetStopInfo(string_view stop_name) const {
-    const domain::Stop* stop = GetStop(stop_name);
+    const auto stop = FindStopId(stop_name);
     if (!stop) {
         return nullopt;
     }
 
-    domain::StopInfo info;
-    
-    auto it = stop_to_buses_.find(stop);
-    if (it != stop_to_buses_.end()) {
-        for (const auto& bus_name : it->second) {
-            info.buses.insert(string(bus_name));
-        }
-    }
-    
-    return info;
+    const auto& stop_buses = stop_to_buses_[*stop];
+    return domain::StopInfo{{stop_buses.data(), stop_buses.data() + stop_buses.size()}};
 }
 
-vector<const domain::Bus*> TransportCatalogue::GetAllBusesSorted() const {
-    vector<const domain::Bus*> result;
-    for (const auto& [name, bus] : bus_name_to_bus_) {
-        result.push_back(bus);
-    }
-    
-    // Сортируем по имени
-    sort(result.begin(), result.end(), [](const domain::Bus* lhs, const domain::Bus* rhs) {
-        return lhs->name < rhs->name;
-    });
-    
-    return result;
+ranges::Range<const domain::BusId*> TransportCatalogue::GetAllBusesSorted() const {
+    return ranges::AsSpan(sorted_buses_);
 }
 
-vector<const domain::Stop*> TransportCatalogue::GetStopsUsedInRoutes() const {
-    vector<const domain::Stop*> result;
-    
-    for (const auto& [stop, buses] : stop_to_buses_) {
-        if (!buses.empty()) {
-            result.push_back(stop);
-        }
-    }
-    
-    return result;
+ranges::Range<const domain::StopId*> TransportCatalogue::GetStopsUsedInRoutes() const {
+    return ranges::AsSpan(sorted_used_stops_);
 }
 
-int TransportCatalogue::GetDistanceByRoad(const domain::Stop* from, const domain::Stop* to) const {
-    auto it = stops_distances_.find({from, to});
+int TransportCatalogue::GetDistanceByRoad(domain::StopId from, domain::StopId to) const {
+    if (IsFrozen()) {
+        const RoadDistance* road_distance = FindRoadDistance(from, to);
+        return road_distance && !road_distance->reverse ? road_distance->distance : 0;
+    }
+    auto it = stops_distances_.find(MakeDistanceKey(from, to));
     if (it != stops_distances_.end()) {
         return it->second;
     }
     return 0;
 }
 
-double TransportCatalogue::GetDistanceBetween(const domain::Stop* from, const domain::Stop* to) const {
+double TransportCatalogue::GetDistanceBetween(domain::StopId from, domain::StopId to) const {
     return static_cast<double>(GetDistance(from, to));
 }
 
-const unordered_map<string_view, const domain::Stop*>& TransportCatalogue::GetAllStops() const {
-    return stop_name_to_stop_;
-}
-
-const unordered_map<string_view, const domain::Bus*>& TransportCatalogue::GetAllBuses() const {
+const TransportCatalogue::BusIndex& TransportCatalogue::GetAllBuses() const {
     return bus_name_to_bus_;
 }
 
 int TransportCatalogue::GetStopsCount() const {
-    return stops_.size();
+    return stop_latitudes_.size();
+}
+
+int TransportCatalogue::GetBusesCount() const {
+    return buses_.size();
 }
 
 void TransportCatalogue::SetRoutingSettings(const domain::RoutingSettings& settings) {
+    // Фоновое построение читает настройки и каталог, поэтому сначала дожидаемся его
+    WaitRouter();
+    lock_guard guard(router_mutex_);
     routing_settings_ = settings;
-    router_built_ = false;  
+    router_future_ = {};
 }
 
 const domain::RoutingSettings& TransportCatalogue::GetRoutingSettings() const {
     return routing_settings_;
 }
 
+void TransportCatalogue::SetSerializationSettings(const domain::SerializationSettings& settings) {
+    WaitRouter();
+    lock_guard guard(router_mutex_);
+    serialization_settings_ = settings;
+}
+
 void TransportCatalogue::BuildRouter() {
-    if (!router_built_) {
-        router_ = make_shared<TransportRouter>(*this, routing_settings_);
-        router_->BuildGraph();
-        router_built_ = true;
+    lock_guard guard(router_mutex_);
+    if (!router_future_.valid()) {
+        router_future_ = StartRouterBuild();
     }
 }
 
 shared_ptr<TransportRouter> TransportCatalogue::GetRouter() const {
-    if (!router_built_) {
-        throw runtime_error("Router has not been built yet. Call BuildRouter() first.");
+    shared_future<shared_ptr<TransportRouter>> router_future;
+    {
+        lock_guard guard(router_mutex_);
+        if (!router_future_.valid()) {
+            router_future_ = StartRouterBuild();
+        }
+        router_future = router_future_;
     }
-    return router_;
+    return router_future.get();
+}
+
+void TransportCatalogue::ReportMemory(memory::MemoryReport& report) const {
+    report.Add("stops", memory::GetHeapBytes(stop_latitudes_) + memory::GetHeapBytes(stop_longitudes_)
+                            + memory::GetHeapBytes(stop_geo_terms_));
+    report.Add("stop_names", memory::GetHeapBytes(stop_names_) + memory::GetHeapBytes(stop_name_offsets_));
+    report.Add("stop_name_index", memory::GetHeapBytes(stop_name_index_));
+    report.Add("stop_grid", stop_grid_.GetMemoryUsage());
+
+    size_t buses_bytes = buses_bytes_;
+    for (const domain::Bus& bus : buses_) {
+        buses_bytes += memory::GetHeapBytes(bus.name) + memory::GetHeapBytes(bus.stops);
+    }
+    report.Add("buses", buses_bytes, memory::Accounting::ALLOCATOR);
+    report.Add("bus_name_index", bus_index_bytes_, memory::Accounting::ALLOCATOR);
+    report.Add("stop_to_buses", memory::GetHeapBytes(stop_to_buses_));
+    report.Add("name_orders", memory::GetHeapBytes(sorted_buses_) + memory::GetHeapBytes(sorted_used_stops_));
+    report.Add("stop_distances", distances_bytes_ + memory::GetHeapBytes(distance_offsets_)
+                                     + memory::GetHeapBytes(road_distances_), memory::Accounting::ALLOCATOR);
+    report.Add("bus_infos", memory::GetHeapBytes(bus_infos_));
+
+    if (const auto router = WaitRouter()) {
+        router->ReportMemory(report);
+    }
+}
+
+shared_ptr<TransportRouter> TransportCatalogue::WaitRouter() const {
+    shared_future<shared_ptr<TransportRouter>> router_future;
+    {
+        lock_guard guard(router_mutex_);
+        router_future = router_future_;
+    }
+    return router_future.valid() ? router_future.get() : nullptr;
+}
+
+shared_future<shared_ptr<TransportRouter>> TransportCatalogue::StartRouterBuild() const {
+    return async(launch::async, [this, settings = routing_settings_, file = serialization_settings_.file]() {
+        auto router = make_shared<TransportRouter>(*this, settings);
+        if (!file.empty() && router->LoadFromFile(file)) {
+            return router;
+        }
+        router->BuildGraph();
+        if (!file.empty()) {
+            // Роутер уже построен, а файл — только кэш, поэтому ошибку записи пропускаем
+            try {
+                router->SaveToFile(file);
+            } catch (const runtime_error&) {
+            }
+        }
+        return router;
+    }).share();
 }
 
 } // namespace transport
\ No newline at end of file
@@ -1,15 +1,19 @@
 #pragma once
 
 #include "domain.h"
+#include "spatial_index.h"
+#include "memory_report.h"
 
+#include <cstdint>
 #include <deque>
 #include <unordered_map>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <optional>
-#include <set>
 #include <memory>
+#include <future>
+#include <mutex>
 
 // Forward declaration
 namespace transport {
@@ -20,47 +24,209 @@ namespace transport {
 
 class TransportCatalogue {
 public:
-    void AddStop(const std::string& name, geo::Coordinates coords);
-    void AddBus(const std::string& name, const std::vector<std::string>& stop_names, bool is_roundtrip);
-    void AddDistance(const std::string& from, const std::string& to, int distance);
+    using BusIndex = memory::CountedHashMap<std::string_view, const domain::Bus*>;
+
+    TransportCatalogue() = default;
+    // Копирует данные каталога. Если у оригинала роутер построен, копия получает его граф
+    // и дальше правит его точечно, иначе роутер копии строится при первом обращении.
+    // Файл роутера у копии не задан, иначе одновременно живущие версии писали бы в один
+    // файл. Копия нужна для новой версии в VersionedCatalogue
+    TransportCatalogue(const TransportCatalogue& other);
+    TransportCatalogue& operator=(const TransportCatalogue&) = delete;
+
+    void AddStop(std::string_view name, geo::Coordinates coords);
+    void AddBus(std::string_view name, const std::vector<std::string_view>& stop_names, bool is_roundtrip);
+    void AddDistance(std::string_view from, std::string_view to, int distance);
+
+    // Пакетная загрузка. Входные данные — представления строк вызывающего, в каталог
+    // строки копируются один раз. Порядок тот же, что и у одиночных методов: остановки,
+    // расстояния, автобусы. Если роутер уже построен, после пакета он строится заново
+    struct Capacity {
+        size_t stop_count = 0;
+        size_t stop_names_size = 0; // суммарная длина названий остановок
+        size_t distance_count = 0;
+        size_t bus_count = 0;
+    };
+    struct StopInput {
+        std::string_view name;
+        geo::Coordinates coordinates;
+    };
+    struct DistanceInput {
+        std::string_view from;
+        std::string_view to;
+        int distance;
+    };
+    struct BusInput {
+        std::string_view name;
+        ranges::Range<const std::string_view*> stops;
+        bool is_roundtrip;
+    };
+    // Резервирует место под ещё столько элементов, сколько указано в capacity,
+    // чтобы массивы и индексы не перестраивались по ходу загрузки
+    void Reserve(const Capacity& capacity);
+    void AddStops(ranges::Range<const StopInput*> stops);
+    void AddDistances(ranges::Range<const DistanceInput*> distances);
+    void AddBuses(ranges::Range<const BusInput*> buses);
+    // Упаковывает дорожные расстояния в построчный формат (CSR): расстояния от каждой
+    // остановки лежат подряд, упорядоченные по номеру остановки назначения. Вызывается
+    // после загрузки; изменения после заморозки допустимы и сохраняют упаковку
+    void Freeze();
+    bool IsFrozen() const;
+    // Номер удалённого автобуса больше не используется, его остановки очищаются
+    void RemoveBus(std::string_view name);
     
     void SetRoutingSettings(const domain::RoutingSettings& settings);
     const domain::RoutingSettings& GetRoutingSettings() const;
+    // Если задан файл, роутер загружается из него, а построенный заново — сохраняется в него
+    void SetSerializationSettings(const domain::SerializationSettings& settings);
+    // BuildRouter запускает построение роутера в фоновом потоке и сразу возвращает
+    // управление: запросы, не требующие маршрутов, обслуживаются параллельно с ним.
+    // GetRouter ждёт окончания построения, а если оно не запускалось — запускает его.
+    // Изменения каталога после BuildRouter переносятся в построенный роутер точечно
     void BuildRouter();
     std::shared_ptr<TransportRouter> GetRouter() const;
     
-    double GetDistanceBetween(const domain::Stop* from, const domain::Stop* to) const;
-    const std::unordered_map<std::string_view, const domain::Stop*>& GetAllStops() const;
-    const std::unordered_map<std::string_view, const domain::Bus*>& GetAllBuses() const;
+    double GetDistanceBetween(domain::StopId from, domain::StopId to) const;
+    const BusIndex& GetAllBuses() const;
     int GetStopsCount() const;
-    int GetDistanceByRoad(const domain::Stop* from, const domain::Stop* to) const;
+    int GetBusesCount() const;
+    int GetDistanceByRoad(domain::StopId from, domain::StopId to) const;
 
     const domain::Bus* GetBus(std::string_view name) const;
-    const domain::Stop* GetStop(std::string_view name) const;
-    int GetDistance(const domain::Stop* from, const domain::Stop* to) const;
+    std::optional<domain::Stop> GetStop(std::string_view name) const;
+    // Номера выдаются подряд с нуля, поэтому доступ по номеру не требует поиска
+    domain::Stop GetStop(domain::StopId id) const;
+    const domain::Bus* GetBus(domain::BusId id) const;
+    std::string_view GetStopName(domain::StopId id) const;
+    geo::Coordinates GetStopCoordinates(domain::StopId id) const;
+    // Посчитанная при добавлении тригонометрия координат для geo::ComputeDistance
+    const geo::PointTerms& GetStopGeoTerms(domain::StopId id) const;
+    // Координаты всех остановок по номерам, подряд в памяти
+    const std::vector<double>& GetStopLatitudes() const;
+    const std::vector<double>& GetStopLongitudes() const;
+    int GetDistance(domain::StopId from, domain::StopId to) const;
 
+    // Считает BusInfo всех автобусов параллельно и сохраняет в таблицу по номеру автобуса:
+    // после этого GetBusInfo не считает ничего. Изменения автобусов и расстояний
+    // пересчитывают строки затронутых автобусов
+    void PrecomputeBusInfo();
     std::optional<domain::BusInfo> GetBusInfo(std::string_view bus_name) const;
+
+    // Остановки не дальше radius метров от center по возрастанию расстояния. Расстояния
+    // считаются только до остановок из ячеек сетки, пересекающих круг
+    std::vector<domain::NearbyStop> FindStopsInRadius(geo::Coordinates center, double radius) const;
+    // count ближайших к center остановок по возрастанию расстояния
+    std::vector<domain::NearbyStop> FindNearestStops(geo::Coordinates center, size_t count) const;
     std::optional<domain::StopInfo> GetStopInfo(std::string_view stop_name) const;
 
-    std::vector<const domain::Bus*> GetAllBusesSorted() const;
-    std::vector<const domain::Stop*> GetStopsUsedInRoutes() const;
+    // Номера действующих автобусов и остановок, через которые проходит хотя бы один
+    // автобус, по возрастанию названия. Массивы поддерживаются каталогом, вызов ничего
+    // не сортирует. Диапазоны действительны до следующего изменения каталога
+    ranges::Range<const domain::BusId*> GetAllBusesSorted() const;
+    ranges::Range<const domain::StopId*> GetStopsUsedInRoutes() const;
+
+    // Память структур каталога и, если роутер уже построен, его структур. Построение
+    // роутера не запускает, но ждёт окончания начатого
+    void ReportMemory(memory::MemoryReport& report) const;
 
 private:
-    std::deque<domain::Stop> stops_;
-    std::deque<domain::Bus> buses_;
+    static constexpr domain::StopId NO_STOP = static_cast<domain::StopId>(-1);
 
-    std::unordered_map<std::string_view, const domain::Stop*> stop_name_to_stop_;
-    std::unordered_map<std::string_view, const domain::Bus*> bus_name_to_bus_;
-    std::unordered_map<const domain::Stop*, std::set<std::string>> stop_to_buses_;
+    std::optional<domain::StopId> FindStopId(std::string_view name) const;
+    // Вставляет номер в индекс имён, при необходимости увеличивая таблицу
+    void IndexStopName(domain::StopId id);
+    // Заменяет таблицу индекса имён на таблицу размера size и заносит в неё остановки
+    // с номерами меньше indexed_count
+    void ResizeStopNameIndex(size_t size, domain::StopId indexed_count);
+    // Данные остановки и автобуса без уведомления роутера
+    domain::StopId InsertStop(std::string_view name, geo::Coordinates coords);
+    domain::BusId InsertBus(std::string_view name, ranges::Range<const std::string_view*> stop_names,
+                            bool is_roundtrip);
+    // Убирает автобус, уже вынутый из индекса названий, из остальных структур без
+    // уведомления роутера. Номер остаётся занятым, маршрут становится пустым
+    void DetachBus(domain::Bus& bus);
+    void DropRouter(const std::shared_ptr<TransportRouter>& router);
+    // Сортирует упорядоченные по названию массивы заново, после пакетной загрузки
+    void RebuildNameOrders();
+    // Точечно ставит на место добавленный автобус и его новые остановки
+    void InsertIntoNameOrders(domain::BusId bus);
+    // Убирает удалённый автобус и остановки, через которые больше никто не проходит
+    void EraseFromNameOrders(const domain::Bus& bus);
+    bool StopNameLess(domain::StopId lhs, domain::StopId rhs) const;
 
-    struct PairStopHasher {
-        size_t operator()(const std::pair<const domain::Stop*, const domain::Stop*>& stops) const;
+    // Остановки хранятся по столбцам: координаты в двух массивах, имена подряд в одной
+    // строке, имя остановки id занимает [stop_name_offsets_[id], stop_name_offsets_[id + 1])
+    std::vector<double> stop_latitudes_;
+    std::vector<double> stop_longitudes_;
+    std::vector<geo::PointTerms> stop_geo_terms_;
+    // Сетка перестраивается при заморозке, новые остановки добавляются в неё сразу
+    spatial::GridIndex stop_grid_;
+    std::string stop_names_;
+    std::vector<uint32_t> stop_name_offsets_{0};
+    // Индекс имён с открытой адресацией: хранит номера остановок, имена берутся из
+    // stop_names_, поэтому рост строки имён индекс не портит. NO_STOP — пустая ячейка
+    std::vector<domain::StopId> stop_name_index_;
+
+    // Память узловых контейнеров ведут их аллокаторы, счётчики объявлены раньше контейнеров
+    size_t buses_bytes_ = 0;
+    size_t bus_index_bytes_ = 0;
+    size_t distances_bytes_ = 0;
+
+    memory::CountedDeque<domain::Bus> buses_{memory::CountingAllocator<domain::Bus>(&buses_bytes_)};
+    BusIndex bus_name_to_bus_{BusIndex::allocator_type(&bus_index_bytes_)};
+    // По номеру остановки — номера проходящих через неё автобусов, упорядоченные по
+    // названию, чтобы запрос остановки отдавал их без копирования и сортировки
+    std::vector<std::vector<domain::BusId>> stop_to_buses_;
+    // Упорядочены по названию, у остановок с одинаковым названием — по номеру
+    std::vector<domain::BusId> sorted_buses_;
+    std::vector<domain::StopId> sorted_used_stops_;
+
+    // Bus не должен быть пустым
+    domain::BusInfo ComputeBusInfo(const domain::Bus& bus) const;
+    // Пересчитывает строки таблицы BusInfo, если она построена
+    void RefreshBusInfo(const std::vector<domain::BusId>& buses);
+
+    // Таблица BusInfo по номеру автобуса, nullopt у пустых и удалённых автобусов
+    std::vector<std::optional<domain::BusInfo>> bus_infos_;
+    bool bus_infos_ready_ = false;
+
+    // Расстояние в строке остановки from. Если задано только расстояние to -> from,
+    // оно хранится и в строке from с флагом reverse: дорога в обратную сторону
+    // считается такой же длины
+    struct RoadDistance {
+        domain::StopId to;
+        int distance;
+        bool reverse;
     };
-    std::unordered_map<std::pair<const domain::Stop*, const domain::Stop*>, int, PairStopHasher> stops_distances_;
+
+    // Ключ — номера остановок «откуда» и «куда» в одном числе
+    static uint64_t MakeDistanceKey(domain::StopId from, domain::StopId to) {
+        return (static_cast<uint64_t>(from) << 32) | to;
+    }
+    // Расстояние в упакованной строке from или nullptr
+    RoadDistance* FindRoadDistance(domain::StopId from, domain::StopId to);
+    const RoadDistance* FindRoadDistance(domain::StopId from, domain::StopId to) const;
+    // Дорожное расстояние с учётом обратного направления, nullopt — не задано
+    std::optional<int> FindDistance(domain::StopId from, domain::StopId to) const;
+    // Возвращает упакованные расстояния в stops_distances_
+    void Thaw();
+
+    // До заморозки расстояния хранятся в хэш-таблице, после — только в CSR:
+    // строка остановки id занимает road_distances_[distance_offsets_[id] .. distance_offsets_[id + 1])
+    using DistanceMap = memory::CountedHashMap<uint64_t, int>;
+    DistanceMap stops_distances_{DistanceMap::allocator_type(&distances_bytes_)};
+    std::vector<uint32_t> distance_offsets_;
+    std::vector<RoadDistance> road_distances_;
     
+    // Построенный роутер или nullptr, если построение не запускалось.
+    // Ждёт окончания фонового построения
+    std::shared_ptr<TransportRouter> WaitRouter() const;
+    std::shared_future<std::shared_ptr<TransportRouter>> StartRouterBuild() const;
+
     domain::RoutingSettings routing_settings_;
-    mutable std::shared_ptr<TransportRouter> router_;
-    mutable bool router_built_ = false;
+    domain::SerializationSettings serialization_settings_;
+    mutable std::mutex router_mutex_;
+    mutable std::shared_future<std::shared_ptr<TransportRouter>> router_future_;
 };
 
-} // namespace transport
\ No newline at end of file
+} // namespace transport
@@ -1,174 +1,749 @@
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 
 #include "transport_router.h"
 #include "transport_catalogue.h" 
+#include "parallel.h"
 
 namespace transport {
 
 using namespace std;
 
+namespace {
+
+// Заголовок файла роутера. Версию нужно увеличивать при любом изменении формата
+constexpr uint32_t ROUTER_FILE_MAGIC = 0x46524354; // "TCRF"
+constexpr uint32_t ROUTER_FILE_VERSION = 2;
+
+struct RouterFileHeader {
+    uint32_t magic = ROUTER_FILE_MAGIC;
+    uint32_t version = ROUTER_FILE_VERSION;
+    uint32_t router_type = 0;
+    int32_t bus_wait_time = 0;
+    double bus_velocity = 0.0;
+    uint64_t stop_count = 0;
+    uint64_t bus_count = 0;
+    uint64_t catalogue_fingerprint = 0;
+    // Контрольная сумма всего, что записано после заголовка. В сравнение заголовков
+    // не входит: сумма проверяется отдельно, и несовпадение — это повреждённый файл
+    uint64_t body_checksum = 0;
+
+    bool operator==(const RouterFileHeader& other) const {
+        return magic == other.magic && version == other.version && router_type == other.router_type
+            && bus_wait_time == other.bus_wait_time && bus_velocity == other.bus_velocity
+            && stop_count == other.stop_count && bus_count == other.bus_count
+            && catalogue_fingerprint == other.catalogue_fingerprint;
+    }
+};
+
+// FNV-1a
+class Fingerprint {
+public:
+    void Add(const void* data, size_t size) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash_ = (hash_ ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+
+    // Побайтово хэшируются только числа: у типов с указателями хэш зависел бы от адресов
+    template <typename T>
+    void Add(const T& value) {
+        static_assert(is_arithmetic_v<T>, "Fingerprint hashes only arithmetic values by bytes");
+        Add(&value, sizeof(T));
+    }
+
+    void Add(string_view value) {
+        Add<uint64_t>(value.size());
+        Add(value.data(), value.size());
+    }
+
+    uint64_t Get() const {
+        return hash_;
+    }
+
+private:
+    uint64_t hash_ = 14695981039346656037ull;
+};
+
+} // namespace
+
 TransportRouter::TransportRouter(const TransportCatalogue& catalogue, 
                                  const domain::RoutingSettings& settings)
     : catalogue_(catalogue)
-    , settings_(settings) {
+    , settings_(settings)
+    , route_cache_(settings.route_cache_size) {
+}
+
+TransportRouter::TransportRouter(const TransportRouter& other, const TransportCatalogue& catalogue)
+    : catalogue_(catalogue)
+    , settings_(other.settings_)
+    , edges_info_(other.edges_info_)
+    , bus_edges_(other.bus_edges_)
+    , route_cache_(other.settings_.route_cache_size) {
+    if (other.graph_) {
+        graph_ = make_unique<graph::DirectedWeightedGraph<double>>(*other.graph_);
+        explorer_ = make_unique<graph::DijkstraRouter<double>>(*graph_);
+    }
+    // Движки держат ссылку на граф оригинала, поэтому у копии они свои
+    if (settings_.router_type == domain::RouterType::DIJKSTRA) {
+        if (graph_) {
+            router_ = make_unique<graph::DijkstraRouter<double>>(*graph_);
+        }
+    } else if (graph_ || settings_.router_type == domain::RouterType::RAPTOR) {
+        engines_stale_.store(true, memory_order_release);
+    }
 }
 
 void TransportRouter::BuildGraph() {
     // Очищаем предыдущие данные
-    wait_vertices_.clear();
-    bus_vertices_.clear();
-    edges_info_.clear();
-    vertices_info_.clear();
-    
-    // Подсчитать количество вершин: 2 * количество остановок
-    size_t stop_count = catalogue_.GetAllStops().size();
-    size_t vertex_count = stop_count * 2;
-    
-    graph_ = make_unique<graph::DirectedWeightedGraph<double>>(vertex_count);
-    vertices_info_.resize(vertex_count);
-    
-    // Создать вершины для каждой остановки
-    size_t vertex_id = 0;
-    for (const auto& [name, stop] : catalogue_.GetAllStops()) {
-        // Wait вершина
-        wait_vertices_[stop->name] = vertex_id;
-        vertices_info_[vertex_id] = {stop->name, true};
-        vertex_id++;
-        
-        // Bus вершина
-        bus_vertices_[stop->name] = vertex_id;
-        vertices_info_[vertex_id] = {stop->name, false};
-        vertex_id++;
+    ResetState();
+
+    // RAPTOR работает прямо по маршрутам автобусов и граф не строит
+    if (settings_.router_type == domain::RouterType::RAPTOR) {
+        raptor_ = make_unique<RaptorRouter>(catalogue_, settings_);
+        return;
     }
     
+    // Вершины остановки с номером id: 2 * id (ожидание) и 2 * id + 1 (посадка)
+    const auto stop_count = static_cast<domain::StopId>(catalogue_.GetStopsCount());
+    graph_ = make_unique<graph::DirectedWeightedGraph<double>>(static_cast<size_t>(stop_count) * 2);
+    
     // Добавить Wait ребра
-    for (const auto& [stop_name, wait_vertex] : wait_vertices_) {
+    for (domain::StopId stop = 0; stop < stop_count; ++stop) {
         graph::Edge<double> edge;
-        edge.from = wait_vertex;
-        edge.to = bus_vertices_.at(stop_name);
+        edge.from = GetWaitVertex(stop);
+        edge.to = GetBusVertex(stop);
         edge.weight = settings_.bus_wait_time;
         
-        graph::EdgeId id = graph_->AddEdge(edge);
-        edges_info_[id] = {"", 0, stop_name, stop_name}; // Wait edge
+        graph_->AddEdge(edge);
+        edges_info_.push_back({}); // Wait edge
     }
     
-    // Добавить Bus ребра для каждого маршрута
-    for (const auto& [name, bus] : catalogue_.GetAllBuses()) {
-        AddBusEdges(bus);
+    // Добавить Bus ребра для каждого маршрута. Блоки рёбер автобусов независимы и строятся
+    // параллельно, а затем добавляются в граф в порядке номеров автобусов
+    const auto bus_count = static_cast<domain::BusId>(catalogue_.GetBusesCount());
+    vector<BusEdgesBlock> blocks(bus_count);
+    parallel::ForEachIndex(bus_count, [this, &blocks](size_t i) {
+        blocks[i] = MakeBusEdges(catalogue_.GetBus(static_cast<domain::BusId>(i)));
+    });
+    bus_edges_.resize(bus_count);
+    for (domain::BusId bus = 0; bus < bus_count; ++bus) {
+        AppendBusEdges(bus, move(blocks[bus]));
     }
     
+    // Упаковать граф перед поиском маршрутов
+    graph_->Freeze();
+
     // Создать роутер
-    router_ = make_unique<graph::Router<double>>(*graph_);
+    router_ = MakeRouteEngine();
+    explorer_ = make_unique<graph::DijkstraRouter<double>>(*graph_);
+}
+
+void TransportRouter::AppendBusEdges(domain::BusId bus, BusEdgesBlock block) {
+    bus_edges_[bus] = {graph_->GetEdgeCount(), block.edges.size()};
+    for (const auto& edge : block.edges) {
+        graph_->AddEdge(edge);
+    }
+    edges_info_.insert(edges_info_.end(), block.edges_info.begin(), block.edges_info.end());
+}
+
+void TransportRouter::AddStop(domain::StopId stop) {
+    if (graph_) {
+        // Вершины новой остановки добавляются в конец, её ребро ожидания — последним
+        graph_->Thaw();
+        graph_->AddVertices(GetWaitVertex(stop) + 2 - graph_->GetVertexCount());
+        graph_->AddEdge({GetWaitVertex(stop), GetBusVertex(stop), static_cast<double>(settings_.bus_wait_time)});
+        edges_info_.push_back({});
+        graph_->Freeze();
+    }
+    InvalidateRouteEngines();
+}
+
+void TransportRouter::AddBus(domain::BusId bus) {
+    if (graph_) {
+        if (bus_edges_.size() <= bus) {
+            bus_edges_.resize(bus + 1);
+        }
+        graph_->Thaw();
+        AppendBusEdges(bus, MakeBusEdges(catalogue_.GetBus(bus)));
+        graph_->Freeze();
+    }
+    InvalidateRouteEngines();
+}
+
+void TransportRouter::RemoveBus(domain::BusId bus) {
+    if (graph_ && bus < bus_edges_.size() && bus_edges_[bus].count > 0) {
+        // Номера рёбер должны идти подряд, поэтому рёбра следующих автобусов сдвигаются
+        // на место удалённых
+        const EdgeRange removed = bus_edges_[bus];
+        graph_->RemoveEdges(removed.first, removed.count);
+        edges_info_.erase(edges_info_.begin() + removed.first,
+                          edges_info_.begin() + removed.first + removed.count);
+        for (EdgeRange& range : bus_edges_) {
+            if (range.first > removed.first) {
+                range.first -= removed.count;
+            }
+        }
+        bus_edges_[bus] = {};
+    }
+    InvalidateRouteEngines();
+}
+
+void TransportRouter::UpdateBuses(const vector<domain::BusId>& buses) {
+    if (graph_) {
+        // Набор рёбер автобуса не меняется, поэтому достаточно пересчитать их веса
+        for (const domain::BusId bus : buses) {
+            const BusEdgesBlock block = MakeBusEdges(catalogue_.GetBus(bus));
+            const EdgeRange range = bus_edges_.at(bus);
+            if (block.edges.size() != range.count) {
+                throw logic_error("Bus edges changed without AddBus");
+            }
+            for (size_t i = 0; i < range.count; ++i) {
+                graph_->SetEdgeWeight(range.first + i, block.edges[i].weight);
+            }
+        }
+    }
+    InvalidateRouteEngines();
+}
+
+void TransportRouter::InvalidateRouteEngines() {
+    route_cache_.Clear();
+
+    // Граф правится на месте, поэтому Дейкстре, которая хранит только ссылку на него,
+    // обновлять нечего. Остальные движки предподсчитывают данные по весам рёбер, а RAPTOR —
+    // по маршрутам: они удаляются сразу и строятся один раз при следующем запросе, сколько
+    // бы изменений ни пришло до него
+    if (settings_.router_type == domain::RouterType::DIJKSTRA || (!graph_ && !raptor_)) {
+        return;
+    }
+    router_.reset();
+    raptor_.reset();
+    engines_stale_.store(true, memory_order_release);
+}
+
+void TransportRouter::EnsureRouteEngines() const {
+    if (!engines_stale_.load(memory_order_acquire)) {
+        return;
+    }
+    lock_guard guard(engines_mutex_);
+    if (!engines_stale_.load(memory_order_relaxed)) {
+        return;
+    }
+    if (settings_.router_type == domain::RouterType::RAPTOR) {
+        raptor_ = make_unique<RaptorRouter>(catalogue_, settings_);
+    } else {
+        router_ = MakeRouteEngine();
+    }
+    engines_stale_.store(false, memory_order_release);
+}
+
+void TransportRouter::SaveToFile(const string& path) const {
+    EnsureRouteEngines();
+    RouterFileHeader header;
+    header.router_type = static_cast<uint32_t>(settings_.router_type);
+    header.bus_wait_time = settings_.bus_wait_time;
+    header.bus_velocity = settings_.bus_velocity;
+    header.stop_count = catalogue_.GetStopsCount();
+    header.bus_count = catalogue_.GetBusesCount();
+    header.catalogue_fingerprint = ComputeCatalogueFingerprint();
+
+    // Пишем во временный файл и переименовываем, чтобы читатели не увидели его недописанным
+    const string temp_path = path + ".tmp"s;
+    {
+        ofstream output(temp_path, ios::binary | ios::trunc);
+        if (!output) {
+            throw runtime_error("Cannot write router file "s + temp_path);
+        }
+        serialization::Writer writer(output);
+        writer.Write(header);
+        if (graph_) {
+            graph_->Save(writer);
+            writer.WriteVector(edges_info_);
+            writer.WriteVector(bus_edges_);
+            router_->Save(writer);
+        }
+        if (!output) {
+            throw runtime_error("Cannot write router file "s + temp_path);
+        }
+    }
+    // Сумма считается по записанному файлу и вписывается в заголовок на место нуля
+    {
+        const serialization::MappedFile written(temp_path);
+        header.body_checksum = serialization::ComputeChecksum(
+            written.GetData() + sizeof(RouterFileHeader), written.GetSize() - sizeof(RouterFileHeader));
+    }
+    {
+        fstream output(temp_path, ios::binary | ios::in | ios::out);
+        serialization::Writer writer(output);
+        writer.Write(header);
+        if (!output) {
+            throw runtime_error("Cannot write router file "s + temp_path);
+        }
+    }
+    if (rename(temp_path.c_str(), path.c_str()) != 0) {
+        remove(temp_path.c_str());
+        throw runtime_error("Cannot write router file "s + path);
+    }
+}
+
+bool TransportRouter::LoadFromFile(const string& path) {
+    unique_ptr<serialization::MappedFile> file;
+    try {
+        file = make_unique<serialization::MappedFile>(path);
+    } catch (const runtime_error&) {
+        return false;
+    }
+    serialization::Reader reader(file->GetData(), file->GetSize());
+
+    RouterFileHeader expected;
+    expected.router_type = static_cast<uint32_t>(settings_.router_type);
+    expected.bus_wait_time = settings_.bus_wait_time;
+    expected.bus_velocity = settings_.bus_velocity;
+    expected.stop_count = catalogue_.GetStopsCount();
+    expected.bus_count = catalogue_.GetBusesCount();
+    expected.catalogue_fingerprint = ComputeCatalogueFingerprint();
+    if (file->GetSize() < sizeof(RouterFileHeader)) {
+        return false;
+    }
+    const auto header = reader.Read<RouterFileHeader>();
+    if (!(header == expected)) {
+        return false;
+    }
+    // Размеры массивов Reader проверяет сам, а испорченные номера вершин и рёбер внутри
+    // массивов привели бы к чтению за границами при поиске
+    if (serialization::ComputeChecksum(file->GetData() + sizeof(RouterFileHeader),
+                                       file->GetSize() - sizeof(RouterFileHeader)) != header.body_checksum) {
+        return false;
+    }
+
+    ResetState();
+
+    // RAPTOR строится линейно по маршрутам, в файле для него только заголовок
+    if (settings_.router_type == domain::RouterType::RAPTOR) {
+        raptor_ = make_unique<RaptorRouter>(catalogue_, settings_);
+        return true;
+    }
+
+    try {
+        graph_ = make_unique<graph::DirectedWeightedGraph<double>>(reader);
+        edges_info_ = reader.ReadVector<EdgeInfo>();
+        bus_edges_ = reader.ReadVector<EdgeRange>();
+        if (graph_->GetVertexCount() != expected.stop_count * 2 || edges_info_.size() != graph_->GetEdgeCount()
+            || bus_edges_.size() != expected.bus_count)
+        {
+            throw runtime_error("Router file "s + path + " does not match the catalogue"s);
+        }
+        router_ = LoadRouteEngine(reader);
+    } catch (const runtime_error&) {
+        // Файл — только кэш: недочитанный файл заменяется построенным заново
+        ResetState();
+        return false;
+    }
+    explorer_ = make_unique<graph::DijkstraRouter<double>>(*graph_);
+    return true;
+}
+
+void TransportRouter::ResetState() {
+    edges_info_.clear();
+    bus_edges_.clear();
+    router_.reset();
+    explorer_.reset();
+    raptor_.reset();
+    graph_.reset();
+    route_cache_.Clear();
+    engines_stale_.store(false, memory_order_release);
+}
+
+uint64_t TransportRouter::ComputeCatalogueFingerprint() const {
+    Fingerprint fingerprint;
+    const auto stop_count = static_cast<domain::StopId>(catalogue_.GetStopsCount());
+    for (domain::StopId stop_id = 0; stop_id < stop_count; ++stop_id) {
+        const domain::Stop stop = catalogue_.GetStop(stop_id);
+        fingerprint.Add(stop.name);
+        fingerprint.Add(stop.coordinates.lat);
+        fingerprint.Add(stop.coordinates.lng);
+    }
+    const auto bus_count = static_cast<domain::BusId>(catalogue_.GetBusesCount());
+    for (domain::BusId bus_id = 0; bus_id < bus_count; ++bus_id) {
+        const domain::Bus* bus = catalogue_.GetBus(bus_id);
+        fingerprint.Add(string_view(bus->name));
+        fingerprint.Add(bus->is_roundtrip);
+        for (size_t i = 0; i < bus->stops.size(); ++i) {
+            fingerprint.Add(bus->stops[i]);
+            if (i > 0) {
+                fingerprint.Add(catalogue_.GetDistanceBetween(bus->stops[i - 1], bus->stops[i]));
+                fingerprint.Add(catalogue_.GetDistanceBetween(bus->stops[i], bus->stops[i - 1]));
+            }
+        }
+    }
+    return fingerprint.Get();
+}
+
+unique_ptr<graph::RouteEngine<double>> TransportRouter::LoadRouteEngine(serialization::Reader& reader) const {
+    switch (settings_.router_type) {
+        case domain::RouterType::ALL_PAIRS:
+            return make_unique<graph::Router<double>>(*graph_, reader);
+        case domain::RouterType::ALL_PAIRS_BLOCKED:
+            return make_unique<graph::BlockedAllPairsRouter<double>>(*graph_, reader);
+        case domain::RouterType::CONTRACTION_HIERARCHIES:
+            return make_unique<graph::ContractionHierarchyRouter<double>>(*graph_, reader);
+        case domain::RouterType::DIJKSTRA:
+        case domain::RouterType::ASTAR:
+        case domain::RouterType::RAPTOR:
+            // Предподсчёт этих движков линеен по размеру графа
+            break;
+    }
+    return MakeRouteEngine();
 }
 
-void TransportRouter::AddBusEdges(const domain::Bus* bus) {
+unique_ptr<graph::RouteEngine<double>> TransportRouter::MakeRouteEngine() const {
+    switch (settings_.router_type) {
+        case domain::RouterType::ALL_PAIRS:
+            return make_unique<graph::Router<double>>(*graph_);
+        case domain::RouterType::ALL_PAIRS_BLOCKED:
+            return make_unique<graph::BlockedAllPairsRouter<double>>(*graph_);
+        case domain::RouterType::DIJKSTRA:
+            return make_unique<graph::DijkstraRouter<double>>(*graph_);
+        case domain::RouterType::ASTAR:
+            return make_unique<graph::BidirectionalAStarRouter<double>>(
+                *graph_, MakeTravelTimeLowerBound());
+        case domain::RouterType::CONTRACTION_HIERARCHIES:
+            return make_unique<graph::ContractionHierarchyRouter<double>>(*graph_);
+        case domain::RouterType::RAPTOR:
+            break;
+    }
+    throw logic_error("Unknown router type");
+}
+
+graph::BidirectionalAStarRouter<double>::LowerBound TransportRouter::MakeTravelTimeLowerBound() const {
+    // Дорожное расстояние может быть меньше географического, поэтому берём наименьшее
+    // отношение дороги к прямой по всем перегонам: любой путь автобуса не короче
+    // min_ratio * (расстояние по прямой между концами)
+    double min_ratio = numeric_limits<double>::infinity();
+    const auto account_segment = [this, &min_ratio](domain::StopId from, domain::StopId to) {
+        const double geo_distance = geo::ComputeDistance(catalogue_.GetStopGeoTerms(from),
+                                                         catalogue_.GetStopGeoTerms(to));
+        if (geo_distance > 0) {
+            min_ratio = min(min_ratio, catalogue_.GetDistanceBetween(from, to) / geo_distance);
+        }
+    };
+    for (const auto& [name, bus] : catalogue_.GetAllBuses()) {
+        for (size_t i = 1; i < bus->stops.size(); ++i) {
+            account_segment(bus->stops[i - 1], bus->stops[i]);
+            if (!bus->is_roundtrip) {
+                account_segment(bus->stops[i], bus->stops[i - 1]);
+            }
+        }
+    }
+    if (!isfinite(min_ratio)) {
+        min_ratio = 0.0;
+    }
+
+    // Небольшой запас компенсирует погрешность вычислений с плавающей точкой
+    const double speed_m_per_min = settings_.bus_velocity * 1000.0 / 60.0;
+    const double minutes_per_geo_meter = min_ratio / speed_m_per_min * (1.0 - 1e-6);
+
+    const auto stop_count = static_cast<domain::StopId>(catalogue_.GetStopsCount());
+    vector<geo::PointTerms> stop_terms;
+    stop_terms.reserve(stop_count);
+    for (domain::StopId stop = 0; stop < stop_count; ++stop) {
+        stop_terms.push_back(catalogue_.GetStopGeoTerms(stop));
+    }
+
+    return [stop_terms = move(stop_terms), minutes_per_geo_meter](
+               graph::VertexId from, graph::VertexId to) {
+        return geo::ComputeDistance(stop_terms[GetVertexStop(from)], stop_terms[GetVertexStop(to)])
+            * minutes_per_geo_meter;
+    };
+}
+
+TransportRouter::BusEdgesBlock TransportRouter::MakeBusEdges(const domain::Bus* bus) const {
     const auto& stops = bus->stops;
-    
+    BusEdgesBlock block;
+    if (stops.size() < 2) {
+        return block;
+    }
+
+    // Накопленные расстояния от первой остановки: forward_distances[i] — по ходу маршрута
+    // до stops[i], backward_distances[i] — обратным ходом от stops[i] до первой остановки.
+    // Расстояние любого отрезка маршрута получается разностью за O(1)
+    vector<double> forward_distances(stops.size(), 0.0);
+    vector<double> backward_distances(stops.size(), 0.0);
+    for (size_t i = 1; i < stops.size(); ++i) {
+        forward_distances[i] = forward_distances[i - 1] + catalogue_.GetDistanceBetween(stops[i - 1], stops[i]);
+        if (!bus->is_roundtrip) {
+            backward_distances[i] = backward_distances[i - 1] + catalogue_.GetDistanceBetween(stops[i], stops[i - 1]);
+        }
+    }
+
+    // Время в минутах = (расстояние в метрах) / (скорость в м/мин)
+    // скорость в м/мин = (velocity км/ч) * (1000 м / 60 мин)
+    const double speed_m_per_min = settings_.bus_velocity * 1000.0 / 60.0;
+    const size_t pair_count = stops.size() * (stops.size() - 1) / 2;
+    block.edges.reserve(bus->is_roundtrip ? pair_count : pair_count * 2);
+    block.edges_info.reserve(block.edges.capacity());
+
+    const auto add_edge = [&](size_t from_idx, size_t to_idx, double distance) {
+        block.edges.push_back({GetBusVertex(stops[from_idx]),
+                               GetWaitVertex(stops[to_idx]),
+                               distance / speed_m_per_min});
+        block.edges_info.push_back({bus->id,
+                                    static_cast<uint32_t>(from_idx < to_idx ? to_idx - from_idx : from_idx - to_idx)});
+    };
+
     // Для каждого возможного отрезка на маршруте
     for (size_t i = 0; i < stops.size(); ++i) {
         for (size_t j = i + 1; j < stops.size(); ++j) {
-            double travel_time = ComputeTravelTimeBetween(stops[i], stops[j], i, j, stops);
-            
-            // Прямое направление
-            graph::Edge<double> edge;
-            edge.from = bus_vertices_.at(stops[i]->name);
-            edge.to = wait_vertices_.at(stops[j]->name);
-            edge.weight = travel_time;
-            
-            graph::EdgeId id = graph_->AddEdge(edge);
-            edges_info_[id] = {bus->name, static_cast<int>(j - i), 
-                              stops[i]->name, stops[j]->name};
+            add_edge(i, j, forward_distances[j] - forward_distances[i]);
         }
     }
-    
+
     // Если маршрут не кольцевой, добавляем обратные ребра
     if (!bus->is_roundtrip) {
         for (size_t i = stops.size() - 1; i > 0; --i) {
             for (size_t j = i - 1; j < i; --j) {
-                double travel_time = ComputeTravelTimeBetween(stops[i], stops[j], i, j, stops);
-                
-                graph::Edge<double> edge;
-                edge.from = bus_vertices_.at(stops[i]->name);
-                edge.to = wait_vertices_.at(stops[j]->name);
-                edge.weight = travel_time;
-                
-                graph::EdgeId id = graph_->AddEdge(edge);
-                edges_info_[id] = {bus->name, static_cast<int>(i - j), 
-                                  stops[i]->name, stops[j]->name};
+                add_edge(i, j, backward_distances[i] - backward_distances[j]);
             }
         }
     }
+    return block;
 }
 
-double TransportRouter::ComputeTravelTimeBetween(const domain::Stop* from [[maybe_unused]], 
-                                                const domain::Stop* to [[maybe_unused]],
-                                                size_t from_idx, 
-                                                size_t to_idx,
-                                                const vector<const domain::Stop*>& stops) const {
-    double distance = 0.0;
+shared_ptr<const domain::RouteResponse> TransportRouter::FindRoute(
+    string_view from, string_view to) const {
     
-    // Суммируем расстояния между последовательными остановками
-    if (from_idx < to_idx) {
-        for (size_t i = from_idx; i < to_idx; ++i) {
-            distance += catalogue_.GetDistanceBetween(stops[i], stops[i + 1]);
-        }
-    } else {
-        // Для обратного направления
-        for (size_t i = from_idx; i > to_idx; --i) {
-            distance += catalogue_.GetDistanceBetween(stops[i], stops[i - 1]);
-        }
+    const auto from_stop = catalogue_.GetStop(from);
+    const auto to_stop = catalogue_.GetStop(to);
+    if (!from_stop || !to_stop) {
+        return nullptr;
     }
-    
-    // Время в минутах = (расстояние в метрах) / (скорость в м/мин)
-    // скорость в м/мин = (velocity км/ч) * (1000 м / 60 мин)
-    double speed_m_per_min = settings_.bus_velocity * 1000.0 / 60.0;
-    return distance / speed_m_per_min;
+    return FindRoute(from_stop->id, to_stop->id);
 }
 
-optional<domain::RouteResponse> TransportRouter::FindRoute(
-    string_view from, string_view to) const {
+shared_ptr<const domain::RouteResponse> TransportRouter::FindRoute(
+    domain::StopId from, domain::StopId to) const {
     
-    if (!wait_vertices_.count(string(from)) || 
-        !wait_vertices_.count(string(to))) {
-        return nullopt;
+    const uint64_t key = (static_cast<uint64_t>(from) << 32) | to;
+    if (auto cached = route_cache_.Find(key)) {
+        return move(*cached);
     }
+    auto response = ComputeRoute(from, to);
+    route_cache_.Insert(key, response);
+    return response;
+}
+
+cache::CacheStats TransportRouter::GetCacheStats() const {
+    return route_cache_.GetStats();
+}
+
+void TransportRouter::ReportMemory(memory::MemoryReport& report) const {
+    report.Add("router.graph", graph_ ? graph_->GetMemoryUsage() : 0);
+    report.Add("router.edges_info", memory::GetHeapBytes(edges_info_));
+    report.Add("router.bus_edges", memory::GetHeapBytes(bus_edges_));
+    report.Add("router.engine", router_ ? router_->GetMemoryUsage() : 0);
+    report.Add("router.explorer", explorer_ ? explorer_->GetMemoryUsage() : 0);
+    report.Add("router.raptor", raptor_ ? raptor_->GetMemoryUsage() : 0);
+}
+
+shared_ptr<const domain::RouteResponse> TransportRouter::ComputeRoute(
+    domain::StopId from, domain::StopId to) const {
     
-    graph::VertexId start = wait_vertices_.at(string(from));
-    graph::VertexId finish = wait_vertices_.at(string(to));
-    
-    auto route = router_->BuildRoute(start, finish);
+    EnsureRouteEngines();
+    if (raptor_) {
+        auto response = raptor_->FindRoute(from, to);
+        if (!response) {
+            return nullptr;
+        }
+        return make_shared<const domain::RouteResponse>(move(*response));
+    }
+
+    auto route = router_->BuildRoute(GetWaitVertex(from), GetWaitVertex(to));
     
     if (!route) {
-        return nullopt;
+        return nullptr;
     }
     
+    return make_shared<const domain::RouteResponse>(MakeResponse(route->weight, route->edges));
+}
+
+domain::RouteResponse TransportRouter::MakeResponse(double total_time, const vector<graph::EdgeId>& edges) const {
     domain::RouteResponse response;
-    response.total_time = route->weight;
+    response.total_time = total_time;
+    response.items.reserve(edges.size());
     
-    for (graph::EdgeId edge_id : route->edges) {
-        const auto& edge_info = edges_info_.at(edge_id);
+    for (graph::EdgeId edge_id : edges) {
+        const auto& edge_info = edges_info_[edge_id];
+        const auto& edge = graph_->GetEdge(edge_id);
         
-        if (edge_info.bus_name.empty()) {
+        if (edge_info.bus_id == EdgeInfo::NO_BUS) {
             // Wait edge
             domain::RouteItem item;
             item.type = "Wait";
-            item.stop_name = edge_info.from_stop;
+            item.stop_name = catalogue_.GetStopName(GetVertexStop(edge.from));
             item.time = settings_.bus_wait_time;
-            response.items.push_back(item);
+            response.items.push_back(move(item));
         } else {
             // Bus edge
             domain::RouteItem item;
             item.type = "Bus";
-            item.bus = edge_info.bus_name;
-            item.span_count = edge_info.span_count;
-            item.time = graph_->GetEdge(edge_id).weight;
-            response.items.push_back(item);
+            item.bus = catalogue_.GetBus(edge_info.bus_id)->name;
+            item.span_count = static_cast<int>(edge_info.span_count);
+            item.time = edge.weight;
+            response.items.push_back(move(item));
         }
     }
     
     return response;
 }
 
+optional<vector<domain::ReachableStop>> TransportRouter::FindReachableStops(
+    string_view from, double max_time) const {
+    
+    const auto from_stop = catalogue_.GetStop(from);
+    if (!from_stop) {
+        return nullopt;
+    }
+
+    EnsureRouteEngines();
+    vector<pair<domain::StopId, double>> reachable;
+    if (raptor_) {
+        reachable = raptor_->FindReachableStops(from_stop->id, max_time);
+    } else if (max_time >= 0.0) {
+        // Маршрут заканчивается в вершине ожидания, поэтому остановки берутся только по ним
+        explorer_->ExploreFrom(GetWaitVertex(from_stop->id),
+            [this, &reachable, max_time](graph::VertexId vertex, double weight, graph::EdgeId) {
+                if (weight > max_time) {
+                    return false;
+                }
+                if (vertex == GetWaitVertex(GetVertexStop(vertex))) {
+                    reachable.emplace_back(GetVertexStop(vertex), weight);
+                }
+                return true;
+            });
+    }
+
+    sort(reachable.begin(), reachable.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.second < rhs.second;
+    });
+
+    vector<domain::ReachableStop> stops;
+    stops.reserve(reachable.size());
+    for (const auto& [stop, time] : reachable) {
+        stops.push_back({string(catalogue_.GetStopName(stop)), time});
+    }
+    return stops;
+}
+
+domain::RouteMatrix TransportRouter::BuildRouteMatrix(const vector<string_view>& from,
+                                                      const vector<string_view>& to,
+                                                      bool with_items) const {
+    const auto find_stop_id = [this](string_view name) -> optional<domain::StopId> {
+        const auto stop = catalogue_.GetStop(name);
+        return stop ? optional(stop->id) : nullopt;
+    };
+    vector<optional<domain::StopId>> to_stops;
+    to_stops.reserve(to.size());
+    for (string_view name : to) {
+        to_stops.push_back(find_stop_id(name));
+    }
+
+    EnsureRouteEngines();
+    vector<vector<optional<domain::RouteResponse>>> rows(from.size());
+    if (raptor_) {
+        parallel::ForEachIndex(from.size(), [&](size_t i) {
+            if (const auto from_stop = find_stop_id(from[i])) {
+                rows[i] = raptor_->FindRoutes(*from_stop, to_stops, with_items);
+            } else {
+                rows[i].resize(to.size());
+            }
+        });
+    } else {
+        vector<optional<graph::VertexId>> to_vertices;
+        to_vertices.reserve(to.size());
+        for (const auto& stop : to_stops) {
+            to_vertices.push_back(stop ? optional(GetWaitVertex(*stop)) : nullopt);
+        }
+        parallel::ForEachIndex(from.size(), [&](size_t i) {
+            if (const auto from_stop = find_stop_id(from[i])) {
+                rows[i] = ExploreRoutes(*from_stop, to_vertices, with_items);
+            } else {
+                rows[i].resize(to.size());
+            }
+        });
+    }
+
+    domain::RouteMatrix matrix;
+    matrix.total_times.reserve(rows.size());
+    for (const auto& row : rows) {
+        auto& times = matrix.total_times.emplace_back();
+        times.reserve(row.size());
+        for (const auto& route : row) {
+            times.push_back(route ? optional(route->total_time) : nullopt);
+        }
+    }
+    if (with_items) {
+        matrix.routes = move(rows);
+    }
+    return matrix;
+}
+
+vector<optional<domain::RouteResponse>> TransportRouter::ExploreRoutes(
+    domain::StopId from, const vector<optional<graph::VertexId>>& to_vertices, bool with_items) const {
+    
+    vector<optional<domain::RouteResponse>> routes(to_vertices.size());
+
+    // Поиск останавливается, когда найдены пути до всех нужных вершин
+    const size_t vertex_count = graph_->GetVertexCount();
+    vector<bool> is_target(vertex_count, false);
+    size_t targets_left = 0;
+    for (const auto& vertex : to_vertices) {
+        if (vertex && !is_target[*vertex]) {
+            is_target[*vertex] = true;
+            ++targets_left;
+        }
+    }
+
+    vector<optional<double>> weights(vertex_count);
+    vector<graph::EdgeId> prev_edges(with_items ? vertex_count : 0, graph::NO_EDGE);
+    if (targets_left > 0) {
+        explorer_->ExploreFrom(GetWaitVertex(from),
+            [&](graph::VertexId vertex, double weight, graph::EdgeId prev_edge) {
+                weights[vertex] = weight;
+                if (with_items) {
+                    prev_edges[vertex] = prev_edge;
+                }
+                if (is_target[vertex]) {
+                    --targets_left;
+                }
+                return targets_left > 0;
+            });
+    }
+
+    for (size_t i = 0; i < to_vertices.size(); ++i) {
+        if (!to_vertices[i] || !weights[*to_vertices[i]]) {
+            continue;
+        }
+        const graph::VertexId to = *to_vertices[i];
+        if (!with_items) {
+            routes[i].emplace().total_time = *weights[to];
+            continue;
+        }
+        vector<graph::EdgeId> edges;
+        for (graph::EdgeId edge_id = prev_edges[to]; edge_id != graph::NO_EDGE;
+             edge_id = prev_edges[graph_->GetEdge(edge_id).from]) {
+            edges.push_back(edge_id);
+        }
+        reverse(edges.begin(), edges.end());
+        routes[i] = MakeResponse(*weights[to], edges);
+    }
+    return routes;
+}
+
 } // namespace transport
\ No newline at end of file
@@ -1,13 +1,25 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <string>
 #include <string_view>
 #include <memory>
-#include <unordered_map>
+#include <mutex>
 #include <vector>
 #include <optional>
 
 #include "graph.h"
 #include "router.h"
+#include "dijkstra_router.h"
+#include "astar_router.h"
+#include "blocked_router.h"
+#include "contraction_hierarchy.h"
+#include "raptor_router.h"
+#include "lru_cache.h"
+#include "memory_report.h"
+#include "serialization.h"
 #include "domain.h"
 
 // Вместо #include "transport_catalogue.h" используем forward declaration
@@ -19,39 +31,119 @@ namespace transport {
 
 class TransportRouter {
 public:
+    // Описание ребра графа. Имена остановок и автобусов подставляются только в ответ:
+    // остановка ребра ожидания — это остановка его начальной вершины
     struct EdgeInfo {
-        std::string bus_name;
-        int span_count = 0;
-        std::string from_stop;
-        std::string to_stop;
+        static constexpr domain::BusId NO_BUS = std::numeric_limits<domain::BusId>::max();
+
+        domain::BusId bus_id = NO_BUS; // NO_BUS у ребра ожидания
+        uint32_t span_count = 0;
     };
     
     TransportRouter(const TransportCatalogue& catalogue, const domain::RoutingSettings& settings);
+    // Роутер для копии каталога: граф и описания рёбер копируются, движки с предподсчётом
+    // строятся при первом запросе. catalogue должен совпадать с каталогом other
+    TransportRouter(const TransportRouter& other, const TransportCatalogue& catalogue);
     
     void BuildGraph();
-    std::optional<domain::RouteResponse> FindRoute(std::string_view from, std::string_view to) const;
+
+    // Сохраняет построенное состояние в двоичный файл: граф, описания рёбер и предподсчёт
+    // движка. В заголовке файла — версия формата, настройки, отпечаток каталога и
+    // контрольная сумма остального содержимого
+    void SaveToFile(const std::string& path) const;
+    // Загружает состояние вместо BuildGraph, отображая файл в память. Возвращает false,
+    // если файла нет, он записан другой версией, с другими настройками или по другому
+    // каталогу, или повреждён: файл — только кэш, и тогда роутер строится заново
+    bool LoadFromFile(const std::string& path);
+
+    // Точечные изменения уже построенного роутера: каталог вызывает их при добавлении
+    // остановки или автобуса, удалении автобуса и исправлении расстояний (в UpdateBuses
+    // передаются автобусы, проходящие через изменённый перегон). Меняются только рёбра
+    // затронутых автобусов, а движок с предподсчётом строится заново один раз при
+    // следующем поиске. Вызывать одновременно с поиском маршрутов нельзя
+    void AddStop(domain::StopId stop);
+    void AddBus(domain::BusId bus);
+    void RemoveBus(domain::BusId bus);
+    void UpdateBuses(const std::vector<domain::BusId>& buses);
+    // Возвращает nullptr, если маршрут не найден. Готовые ответы берутся из кэша
+    std::shared_ptr<const domain::RouteResponse> FindRoute(std::string_view from, std::string_view to) const;
+    std::shared_ptr<const domain::RouteResponse> FindRoute(domain::StopId from, domain::StopId to) const;
+    cache::CacheStats GetCacheStats() const;
+    // Память графа, описаний рёбер и движков поиска, по строке на структуру
+    void ReportMemory(memory::MemoryReport& report) const;
+
+    // Остановки, до которых можно доехать из from не дольше max_time минут, по возрастанию
+    // времени. Один поиск, который прекращается, как только время превысит max_time.
+    // nullopt, если остановка from неизвестна
+    std::optional<std::vector<domain::ReachableStop>> FindReachableStops(std::string_view from, double max_time) const;
+
+    // Один поиск на каждую остановку из from, поиски идут параллельно
+    domain::RouteMatrix BuildRouteMatrix(const std::vector<std::string_view>& from,
+                                         const std::vector<std::string_view>& to,
+                                         bool with_items) const;
     
 private:
-    struct VertexInfo {
-        std::string stop_name;
-        bool is_wait; // true - wait vertex, false - bus vertex
+    // У каждой остановки две вершины: ожидания (чётная) и посадки в автобус (нечётная)
+    static graph::VertexId GetWaitVertex(domain::StopId stop) {
+        return static_cast<graph::VertexId>(stop) * 2;
+    }
+    static graph::VertexId GetBusVertex(domain::StopId stop) {
+        return static_cast<graph::VertexId>(stop) * 2 + 1;
+    }
+    static domain::StopId GetVertexStop(graph::VertexId vertex) {
+        return static_cast<domain::StopId>(vertex / 2);
+    }
+
+    // Рёбра одного автобуса вместе с их описаниями, в порядке добавления в граф
+    struct BusEdgesBlock {
+        std::vector<graph::Edge<double>> edges;
+        std::vector<EdgeInfo> edges_info;
     };
-    
-    void AddBusEdges(const domain::Bus* bus);
-    double ComputeTravelTimeBetween(const domain::Stop* from, const domain::Stop* to,
-                                   size_t from_idx, size_t to_idx, 
-                                   const std::vector<const domain::Stop*>& stops) const;
+
+    // Рёбра автобуса занимают в графе подряд идущие номера
+    struct EdgeRange {
+        graph::EdgeId first = 0;
+        size_t count = 0;
+    };
+
+    // Ключ кэша — номера остановок «откуда» и «куда» в одном числе.
+    // Кэш хранит и отсутствие маршрута, в этом случае значение равно nullptr
+    using RouteCache = cache::LruCache<uint64_t, std::shared_ptr<const domain::RouteResponse>>;
+
+    std::shared_ptr<const domain::RouteResponse> ComputeRoute(domain::StopId from, domain::StopId to) const;
+    domain::RouteResponse MakeResponse(double total_time, const std::vector<graph::EdgeId>& edges) const;
+    std::vector<std::optional<domain::RouteResponse>> ExploreRoutes(
+        domain::StopId from, const std::vector<std::optional<graph::VertexId>>& to_vertices, bool with_items) const;
+    BusEdgesBlock MakeBusEdges(const domain::Bus* bus) const;
+    void AppendBusEdges(domain::BusId bus, BusEdgesBlock block);
+    // Удаляет граф, движки и кэш маршрутов
+    void ResetState();
+    // Сбрасывает кэш и помечает движки, зависящие от весов рёбер, устаревшими
+    void InvalidateRouteEngines();
+    // Строит заново устаревшие движки, вызывается перед поиском
+    void EnsureRouteEngines() const;
+    std::unique_ptr<graph::RouteEngine<double>> MakeRouteEngine() const;
+    std::unique_ptr<graph::RouteEngine<double>> LoadRouteEngine(serialization::Reader& reader) const;
+    // Хэш всего, от чего зависит граф: остановок, автобусов и расстояний их перегонов
+    uint64_t ComputeCatalogueFingerprint() const;
+    graph::BidirectionalAStarRouter<double>::LowerBound MakeTravelTimeLowerBound() const;
     
     const TransportCatalogue& catalogue_;
     domain::RoutingSettings settings_;
     
     std::unique_ptr<graph::DirectedWeightedGraph<double>> graph_;
-    std::unique_ptr<graph::Router<double>> router_;
+    // Движок и RAPTOR после изменений каталога строятся заново при первом запросе
+    mutable std::unique_ptr<graph::RouteEngine<double>> router_;
+    // Поиск от одной вершины ко всем для матриц маршрутов, не зависит от router_type
+    std::unique_ptr<graph::DijkstraRouter<double>> explorer_;
+    mutable std::unique_ptr<RaptorRouter> raptor_;
+    mutable std::atomic<bool> engines_stale_{false};
+    mutable std::mutex engines_mutex_;
     
-    std::unordered_map<std::string, graph::VertexId> wait_vertices_;
-    std::unordered_map<std::string, graph::VertexId> bus_vertices_;
-    std::unordered_map<graph::EdgeId, EdgeInfo> edges_info_;
-    std::vector<VertexInfo> vertices_info_;
+    std::vector<EdgeInfo> edges_info_; // по номеру ребра
+    std::vector<EdgeRange> bus_edges_; // по номеру автобуса
+
+    mutable RouteCache route_cache_;
 };
 
 } // namespace transport
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "versioned_catalogue.h"
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+namespace transport {
+
+using namespace std;
+
+VersionedCatalogue::Snapshot::Snapshot(Snapshot&& other) noexcept
+    : slot_(exchange(other.slot_, nullptr))
+    , catalogue_(exchange(other.catalogue_, nullptr)) {
+}
+
+VersionedCatalogue::Snapshot& VersionedCatalogue::Snapshot::operator=(Snapshot&& other) noexcept {
+    if (this != &other) {
+        Release();
+        slot_ = exchange(other.slot_, nullptr);
+        catalogue_ = exchange(other.catalogue_, nullptr);
+    }
+    return *this;
+}
+
+VersionedCatalogue::Snapshot::~Snapshot() {
+    Release();
+}
+
+void VersionedCatalogue::Snapshot::Release() noexcept {
+    if (slot_) {
+        slot_->catalogue.store(nullptr, memory_order_release);
+        slot_->busy.store(false, memory_order_release);
+        slot_ = nullptr;
+        catalogue_ = nullptr;
+    }
+}
+
+VersionedCatalogue::VersionedCatalogue()
+    : VersionedCatalogue(make_unique<TransportCatalogue>()) {
+}
+
+VersionedCatalogue::VersionedCatalogue(unique_ptr<TransportCatalogue> initial)
+    : current_(initial.release()) {
+}
+
+VersionedCatalogue::~VersionedCatalogue() {
+    delete current_.load(memory_order_acquire);
+}
+
+VersionedCatalogue::PinSlot& VersionedCatalogue::ClaimSlot() const {
+    // Потоки начинают поиск свободной ячейки с разных мест, чтобы не соревноваться за первые
+    thread_local const size_t start = hash<thread::id>{}(this_thread::get_id());
+    while (true) {
+        for (size_t i = 0; i < MAX_PINS; ++i) {
+            PinSlot& slot = slots_[(start + i) % MAX_PINS];
+            bool expected = false;
+            if (!slot.busy.load(memory_order_relaxed)
+                && slot.busy.compare_exchange_strong(expected, true, memory_order_acquire)) {
+                return slot;
+            }
+        }
+        this_thread::yield();
+    }
+}
+
+VersionedCatalogue::Snapshot VersionedCatalogue::Acquire() const {
+    PinSlot& slot = ClaimSlot();
+    // Адрес записывается в ячейку до повторного чтения текущей версии. Если версия за это
+    // время не сменилась, писатель, снимая её, увидит адрес в ячейке и не освободит её
+    const TransportCatalogue* catalogue = current_.load(memory_order_acquire);
+    while (true) {
+        slot.catalogue.store(catalogue, memory_order_seq_cst);
+        const TransportCatalogue* published = current_.load(memory_order_seq_cst);
+        if (published == catalogue) {
+            return Snapshot(&slot, catalogue);
+        }
+        catalogue = published;
+    }
+}
+
+uint64_t VersionedCatalogue::GetVersion() const {
+    return version_.load(memory_order_acquire);
+}
+
+void VersionedCatalogue::Reclaim() {
+    lock_guard guard(writer_mutex_);
+    ReclaimRetired();
+}
+
+uint64_t VersionedCatalogue::Publish(unique_ptr<const TransportCatalogue> next) {
+    retired_.emplace_back(current_.exchange(next.release(), memory_order_seq_cst));
+    const uint64_t version = version_.fetch_add(1, memory_order_release) + 1;
+    ReclaimRetired();
+    return version;
+}
+
+void VersionedCatalogue::ReclaimRetired() {
+    vector<const TransportCatalogue*> pinned;
+    for (const PinSlot& slot : slots_) {
+        if (const TransportCatalogue* catalogue = slot.catalogue.load(memory_order_seq_cst)) {
+            pinned.push_back(catalogue);
+        }
+    }
+    sort(pinned.begin(), pinned.end());
+    retired_.erase(remove_if(retired_.begin(), retired_.end(),
+                             [&pinned](const unique_ptr<const TransportCatalogue>& catalogue) {
+                                 return !binary_search(pinned.begin(), pinned.end(), catalogue.get());
+                             }),
+                   retired_.end());
+}
+
+} // namespace transport
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "transport_catalogue.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace transport {
+
+// Каталог с неизменяемыми версиями (RCU) для программ, где запросы идут из многих потоков
+// одновременно с обновлениями. JsonReader обрабатывает пакет последовательно и его не
+// использует. Читатели закрепляют текущую версию и работают с ней без блокировок,
+// писатель применяет изменения к копии и публикует её целиком.
+//
+// Закрепление устроено как указатели опасности (hazard pointers): читатель занимает
+// ячейку и записывает в неё адрес версии, писатель освобождает снятую версию, только
+// если её адреса нет ни в одной ячейке. На пути читателя — только атомарные операции
+// над своей ячейкой и чтение текущей версии, без мьютексов и общих счётчиков ссылок
+class VersionedCatalogue {
+private:
+    // Ячейки на отдельных кэш-линиях, чтобы читатели разных потоков не мешали друг другу
+    struct alignas(64) PinSlot {
+        std::atomic<bool> busy{false};
+        std::atomic<const TransportCatalogue*> catalogue{nullptr};
+    };
+
+public:
+    // Закреплённая версия. Пока объект жив, версия не освобождается. Не должен
+    // переживать свой VersionedCatalogue
+    class Snapshot {
+    public:
+        Snapshot(Snapshot&& other) noexcept;
+        Snapshot& operator=(Snapshot&& other) noexcept;
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        ~Snapshot();
+
+        const TransportCatalogue& operator*() const {
+            return *catalogue_;
+        }
+        const TransportCatalogue* operator->() const {
+            return catalogue_;
+        }
+        const TransportCatalogue* Get() const {
+            return catalogue_;
+        }
+
+    private:
+        friend class VersionedCatalogue;
+        Snapshot(PinSlot* slot, const TransportCatalogue* catalogue)
+            : slot_(slot)
+            , catalogue_(catalogue) {
+        }
+        void Release() noexcept;
+
+        PinSlot* slot_;
+        const TransportCatalogue* catalogue_;
+    };
+
+    // Одновременно закреплённых версий не больше стольких, сверх этого Acquire ждёт,
+    // пока какая-нибудь освободится
+    static constexpr size_t MAX_PINS = 256;
+
+    VersionedCatalogue();
+    explicit VersionedCatalogue(std::unique_ptr<TransportCatalogue> initial);
+    ~VersionedCatalogue();
+
+    VersionedCatalogue(const VersionedCatalogue&) = delete;
+    VersionedCatalogue& operator=(const VersionedCatalogue&) = delete;
+
+    Snapshot Acquire() const;
+    uint64_t GetVersion() const;
+
+    // Применяет update(TransportCatalogue&) к копии текущей версии, публикует результат
+    // и возвращает номер новой версии. Писатели выполняются по очереди. Копия стоит
+    // O(размер каталога). Построенный роутер переносится в копию и правится точечно,
+    // а движок с предподсчётом строится заново при первом запросе к новой версии,
+    // поэтому изменения выгодно собирать в пакеты
+    template <typename Update>
+    uint64_t Apply(Update update);
+
+    // Освобождает снятые версии, которые больше никто не держит. Вызывается и при
+    // каждой публикации
+    void Reclaim();
+
+private:
+    uint64_t Publish(std::unique_ptr<const TransportCatalogue> next);
+    // Вызывается под writer_mutex_
+    void ReclaimRetired();
+    PinSlot& ClaimSlot() const;
+
+    mutable std::array<PinSlot, MAX_PINS> slots_;
+    std::atomic<const TransportCatalogue*> current_;
+    std::atomic<uint64_t> version_{0};
+
+    std::mutex writer_mutex_;
+    // Снятые версии, которые ещё могут быть закреплены читателями
+    std::vector<std::unique_ptr<const TransportCatalogue>> retired_;
+};
+
+template <typename Update>
+uint64_t VersionedCatalogue::Apply(Update update) {
+    std::lock_guard guard(writer_mutex_);
+    // Текущую версию освобождает только писатель, поэтому под мьютексом она жива
+    auto next = std::make_unique<TransportCatalogue>(*current_.load(std::memory_order_acquire));
+    update(*next);
+    return Publish(std::move(next));
+}
+
+} // namespace transport